@@ -0,0 +1,161 @@
+#pragma once
+
+// Structure-of-arrays animation data and the per-key kernels that run over it.
+// Nothing here depends on the FBX SDK; FBXProcessor.h loads curves into these buffers,
+// runs the kernels and writes the values back in one pass.
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define ANIMATION_KERNELS_SSE2 1
+#elif defined(__ARM_NEON) || defined(_M_ARM64)
+#include <arm_neon.h>
+#define ANIMATION_KERNELS_NEON 1
+#endif
+
+// One animated channel: key times in FbxTime ticks and the matching values, both contiguous.
+struct AnimationChannel {
+    std::vector<int64_t> times;
+    std::vector<float> values;
+
+    size_t Size() const { return values.size(); }
+
+    void Resize(size_t count) {
+        times.resize(count);
+        values.resize(count);
+    }
+};
+
+namespace AnimationKernels {
+
+// values[i] += offset
+inline void AddScalar(float* values, size_t count, float offset) {
+    size_t i = 0;
+#if defined(ANIMATION_KERNELS_SSE2)
+    const __m128 offset4 = _mm_set1_ps(offset);
+    for (; i + 4 <= count; i += 4) {
+        _mm_storeu_ps(values + i, _mm_add_ps(_mm_loadu_ps(values + i), offset4));
+    }
+#elif defined(ANIMATION_KERNELS_NEON)
+    const float32x4_t offset4 = vdupq_n_f32(offset);
+    for (; i + 4 <= count; i += 4) {
+        vst1q_f32(values + i, vaddq_f32(vld1q_f32(values + i), offset4));
+    }
+#endif
+    for (; i < count; i++) {
+        values[i] += offset;
+    }
+}
+
+inline void AddScalar(AnimationChannel& channel, float offset) {
+    AddScalar(channel.values.data(), channel.Size(), offset);
+}
+
+// Turns each (x[i], z[i]) about the Y axis through the point (-centerX, -centerZ):
+// x' = cos * (x + cx) + sin * (z + cz) - cx, z' = -sin * (x + cx) + cos * (z + cz) - cz.
+inline void RotateXZ(float* x, float* z, size_t count, float cosYaw, float sinYaw, float centerX, float centerZ) {
+    size_t i = 0;
+#if defined(ANIMATION_KERNELS_SSE2)
+    const __m128 cos4 = _mm_set1_ps(cosYaw);
+    const __m128 sin4 = _mm_set1_ps(sinYaw);
+    const __m128 centerX4 = _mm_set1_ps(centerX);
+    const __m128 centerZ4 = _mm_set1_ps(centerZ);
+    for (; i + 4 <= count; i += 4) {
+        __m128 px = _mm_add_ps(_mm_loadu_ps(x + i), centerX4);
+        __m128 pz = _mm_add_ps(_mm_loadu_ps(z + i), centerZ4);
+        __m128 rx = _mm_add_ps(_mm_mul_ps(cos4, px), _mm_mul_ps(sin4, pz));
+        __m128 rz = _mm_sub_ps(_mm_mul_ps(cos4, pz), _mm_mul_ps(sin4, px));
+        _mm_storeu_ps(x + i, _mm_sub_ps(rx, centerX4));
+        _mm_storeu_ps(z + i, _mm_sub_ps(rz, centerZ4));
+    }
+#elif defined(ANIMATION_KERNELS_NEON)
+    const float32x4_t cos4 = vdupq_n_f32(cosYaw);
+    const float32x4_t sin4 = vdupq_n_f32(sinYaw);
+    const float32x4_t centerX4 = vdupq_n_f32(centerX);
+    const float32x4_t centerZ4 = vdupq_n_f32(centerZ);
+    for (; i + 4 <= count; i += 4) {
+        float32x4_t px = vaddq_f32(vld1q_f32(x + i), centerX4);
+        float32x4_t pz = vaddq_f32(vld1q_f32(z + i), centerZ4);
+        float32x4_t rx = vaddq_f32(vmulq_f32(cos4, px), vmulq_f32(sin4, pz));
+        float32x4_t rz = vsubq_f32(vmulq_f32(cos4, pz), vmulq_f32(sin4, px));
+        vst1q_f32(x + i, vsubq_f32(rx, centerX4));
+        vst1q_f32(z + i, vsubq_f32(rz, centerZ4));
+    }
+#endif
+    for (; i < count; i++) {
+        float px = x[i] + centerX;
+        float pz = z[i] + centerZ;
+        x[i] = (cosYaw * px + sinYaw * pz) - centerX;
+        z[i] = (cosYaw * pz - sinYaw * px) - centerZ;
+    }
+}
+
+inline void RotateXZ(AnimationChannel& channelX, AnimationChannel& channelZ, float cosYaw, float sinYaw,
+                     float centerX, float centerZ) {
+    RotateXZ(channelX.values.data(), channelZ.values.data(), std::min(channelX.Size(), channelZ.Size()),
+             cosYaw, sinYaw, centerX, centerZ);
+}
+
+// Picks the keys to keep so that linear interpolation between kept keys stays within tolerance
+// of every original key. One forward pass: from the current anchor, each key narrows the range
+// of slopes that pass within tolerance of all keys seen so far, and the furthest key whose own
+// slope from the anchor lies inside that range becomes the next anchor. First and last keys are
+// always kept.
+inline std::vector<uint32_t> ReduceLinear(const int64_t* times, const float* values, size_t count, float tolerance) {
+    std::vector<uint32_t> kept;
+    if (count == 0) return kept;
+
+    kept.push_back(0);
+    size_t anchor = 0;
+    while (anchor + 1 < count) {
+        double lowSlope = -std::numeric_limits<double>::infinity();
+        double highSlope = std::numeric_limits<double>::infinity();
+        size_t next = anchor + 1;
+
+        for (size_t j = anchor + 1; j < count; j++) {
+            double dt = static_cast<double>(times[j] - times[anchor]);
+            if (dt <= 0.0) {
+                next = j;
+                break;
+            }
+
+            double slope = (static_cast<double>(values[j]) - values[anchor]) / dt;
+            if (slope >= lowSlope && slope <= highSlope) {
+                next = j;
+            }
+
+            lowSlope = std::max(lowSlope, (static_cast<double>(values[j]) - tolerance - values[anchor]) / dt);
+            highSlope = std::min(highSlope, (static_cast<double>(values[j]) + tolerance - values[anchor]) / dt);
+            if (lowSlope > highSlope) break;
+        }
+
+        kept.push_back(static_cast<uint32_t>(next));
+        anchor = next;
+    }
+
+    return kept;
+}
+
+// Largest absolute difference between the original keys and linear interpolation of the kept ones.
+inline double MaxLinearError(const int64_t* times, const float* values, size_t count, const std::vector<uint32_t>& kept) {
+    double maxError = 0.0;
+    for (size_t k = 0; k + 1 < kept.size(); k++) {
+        size_t start = kept[k];
+        size_t end = kept[k + 1];
+        double dt = static_cast<double>(times[end] - times[start]);
+        for (size_t i = start + 1; i < end && i < count; i++) {
+            double fraction = dt > 0.0 ? static_cast<double>(times[i] - times[start]) / dt : 0.0;
+            double interpolated = values[start] + (static_cast<double>(values[end]) - values[start]) * fraction;
+            maxError = std::max(maxError, std::fabs(interpolated - values[i]));
+        }
+    }
+    return maxError;
+}
+
+} // namespace AnimationKernels
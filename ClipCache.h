@@ -0,0 +1,288 @@
+#pragma once
+
+// Compact per-actor animation cache written next to each exported .fbx with --clip-cache, and a
+// reader that maps the file and hands out pointers into it. Runtime tools only need this header;
+// it does not depend on the FBX SDK.
+//
+// Layout (little-endian, offsets from the start of the file):
+//   Header
+//   Bone table       boneCount    x ClipCacheFormat::Bone, parents before children
+//   Clip table       clipCount    x ClipCacheFormat::Clip, one per animation stack
+//   Channel table    channelCount x ClipCacheFormat::Channel, grouped by clip
+//   String table     null-terminated names referenced by nameOffset
+//   Key data         per channel: int64 times (FbxTime ticks), then float values
+// Tables are 8-byte aligned and every key array starts on a 16-byte boundary, so values can be
+// loaded with aligned SIMD reads straight from the mapping. Keys are meant to be interpolated
+// linearly; the curves they come from are baked or already reduced to linear keys.
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace ClipCacheFormat {
+
+constexpr char Magic[8] = { 'F', 'B', 'X', 'C', 'L', 'I', 'P', '\0' };
+constexpr uint32_t Version = 2;
+constexpr uint64_t TableAlignment = 8;
+constexpr uint64_t KeyAlignment = 16;
+
+enum ChannelProperty : uint16_t {
+    Translation = 0,
+    // Euler angles in degrees, in the bone's rotation order
+    Rotation = 1,
+    Scaling = 2
+};
+
+struct Header {
+    char magic[8];
+    uint32_t version;
+    uint32_t headerSize;
+    uint32_t boneCount;
+    uint32_t clipCount;
+    uint32_t channelCount;
+    uint32_t reserved;
+    uint64_t boneTableOffset;
+    uint64_t clipTableOffset;
+    uint64_t channelTableOffset;
+    uint64_t stringTableOffset;
+    uint64_t stringTableSize;
+    uint64_t fileSize;
+};
+static_assert(sizeof(Header) == 80, "clip cache header layout changed");
+
+// The local matrix is composed as in FBX:
+//   T * Roff * Rp * Rpre * R * Rpost^-1 * Rp^-1 * Soff * Sp * S * Sp^-1
+// with T, R and S the (possibly animated) translation, rotation and scaling, and the rest the
+// static offsets, pivots and pre/post rotations below. The facing yaw of an actor turned with
+// rotate_to_face_z lives in its root's preRotation.
+struct Bone {
+    uint32_t nameOffset;
+    // -1 for a root
+    int32_t parentIndex;
+    // local transform when no animation is applied
+    float translation[3];
+    float rotation[3];
+    float scaling[3];
+    // FbxEuler::EOrder of the source node, applied to rotation only
+    uint32_t rotationOrder;
+    // Euler degrees in XYZ order, zero when the source node has rotation inactive
+    float preRotation[3];
+    float postRotation[3];
+    float rotationOffset[3];
+    float rotationPivot[3];
+    float scalingOffset[3];
+    float scalingPivot[3];
+};
+static_assert(sizeof(Bone) == 120, "clip cache bone layout changed");
+
+struct Clip {
+    uint32_t nameOffset;
+    uint32_t firstChannel;
+    uint32_t channelCount;
+    uint32_t reserved;
+    int64_t startTime;
+    int64_t stopTime;
+};
+static_assert(sizeof(Clip) == 32, "clip cache clip layout changed");
+
+struct Channel {
+    uint32_t boneIndex;
+    uint16_t property;
+    // 0, 1, 2 for X, Y, Z
+    uint16_t component;
+    // animation layer within the clip
+    uint32_t layerIndex;
+    uint32_t keyCount;
+    uint64_t timesOffset;
+    uint64_t valuesOffset;
+};
+static_assert(sizeof(Channel) == 32, "clip cache channel layout changed");
+
+inline uint64_t Align(uint64_t offset, uint64_t alignment) {
+    return (offset + alignment - 1) & ~(alignment - 1);
+}
+
+} // namespace ClipCacheFormat
+
+// Read-only view of a clip cache file. Open maps the file and validates every table and offset
+// once, so the accessors below are plain pointer arithmetic.
+class ClipCacheFile {
+private:
+    const unsigned char* data = nullptr;
+    uint64_t size = 0;
+#if defined(_WIN32)
+    HANDLE file = INVALID_HANDLE_VALUE;
+    HANDLE mapping = nullptr;
+#endif
+
+    template <typename T>
+    const T* At(uint64_t offset) const { return reinterpret_cast<const T*>(data + offset); }
+
+    bool RangeValid(uint64_t offset, uint64_t count, uint64_t elementSize, uint64_t alignment) const {
+        if (offset % alignment != 0 || offset > size) return false;
+        return count <= (size - offset) / elementSize;
+    }
+
+    bool NameValid(uint32_t nameOffset) const { return nameOffset < GetHeader().stringTableSize; }
+
+    bool Validate(std::string& error) const {
+        using namespace ClipCacheFormat;
+        if (size < sizeof(Header)) {
+            error = "File is too small for a clip cache header";
+            return false;
+        }
+
+        const Header& header = GetHeader();
+        if (std::memcmp(header.magic, Magic, sizeof(Magic)) != 0) {
+            error = "Not a clip cache file";
+            return false;
+        }
+        if (header.version != Version || header.headerSize != sizeof(Header)) {
+            error = "Unsupported clip cache version " + std::to_string(header.version);
+            return false;
+        }
+        if (header.fileSize != size) {
+            error = "Clip cache is truncated";
+            return false;
+        }
+
+        if (!RangeValid(header.boneTableOffset, header.boneCount, sizeof(Bone), TableAlignment) ||
+            !RangeValid(header.clipTableOffset, header.clipCount, sizeof(Clip), TableAlignment) ||
+            !RangeValid(header.channelTableOffset, header.channelCount, sizeof(Channel), TableAlignment) ||
+            !RangeValid(header.stringTableOffset, header.stringTableSize, 1, 1) ||
+            header.stringTableSize == 0 || data[header.stringTableOffset + header.stringTableSize - 1] != '\0') {
+            error = "Clip cache table out of range";
+            return false;
+        }
+
+        for (uint32_t i = 0; i < header.boneCount; i++) {
+            const Bone& bone = GetBone(i);
+            if (!NameValid(bone.nameOffset) || bone.parentIndex >= static_cast<int32_t>(i) || bone.parentIndex < -1) {
+                error = "Invalid bone " + std::to_string(i);
+                return false;
+            }
+        }
+        for (uint32_t i = 0; i < header.clipCount; i++) {
+            const Clip& clip = GetClip(i);
+            if (!NameValid(clip.nameOffset) || clip.firstChannel > header.channelCount ||
+                clip.channelCount > header.channelCount - clip.firstChannel) {
+                error = "Invalid clip " + std::to_string(i);
+                return false;
+            }
+        }
+        for (uint32_t i = 0; i < header.channelCount; i++) {
+            const Channel& channel = GetChannel(i);
+            if (channel.boneIndex >= header.boneCount || channel.property > Scaling || channel.component > 2 ||
+                !RangeValid(channel.timesOffset, channel.keyCount, sizeof(int64_t), KeyAlignment) ||
+                !RangeValid(channel.valuesOffset, channel.keyCount, sizeof(float), KeyAlignment)) {
+                error = "Invalid channel " + std::to_string(i);
+                return false;
+            }
+        }
+        return true;
+    }
+
+public:
+    ClipCacheFile() = default;
+    ~ClipCacheFile() { Close(); }
+
+    ClipCacheFile(const ClipCacheFile&) = delete;
+    ClipCacheFile& operator=(const ClipCacheFile&) = delete;
+
+    bool Open(const std::string& path, std::string& error) {
+        Close();
+#if defined(_WIN32)
+        file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        LARGE_INTEGER fileSize;
+        if (file == INVALID_HANDLE_VALUE || !GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0) {
+            error = "Failed to open clip cache: " + path;
+            Close();
+            return false;
+        }
+        mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        void* view = mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+        if (!view) {
+            error = "Failed to map clip cache: " + path;
+            Close();
+            return false;
+        }
+        data = static_cast<const unsigned char*>(view);
+        size = static_cast<uint64_t>(fileSize.QuadPart);
+#else
+        int descriptor = ::open(path.c_str(), O_RDONLY);
+        struct stat status;
+        if (descriptor < 0 || fstat(descriptor, &status) != 0 || status.st_size == 0) {
+            error = "Failed to open clip cache: " + path;
+            if (descriptor >= 0) ::close(descriptor);
+            return false;
+        }
+        void* view = mmap(nullptr, static_cast<size_t>(status.st_size), PROT_READ, MAP_PRIVATE, descriptor, 0);
+        // the mapping keeps the file alive on its own
+        ::close(descriptor);
+        if (view == MAP_FAILED) {
+            error = "Failed to map clip cache: " + path;
+            return false;
+        }
+        data = static_cast<const unsigned char*>(view);
+        size = static_cast<uint64_t>(status.st_size);
+#endif
+        if (!Validate(error)) {
+            Close();
+            return false;
+        }
+        return true;
+    }
+
+    void Close() {
+#if defined(_WIN32)
+        if (data) UnmapViewOfFile(data);
+        if (mapping) CloseHandle(mapping);
+        if (file != INVALID_HANDLE_VALUE) CloseHandle(file);
+        mapping = nullptr;
+        file = INVALID_HANDLE_VALUE;
+#else
+        if (data) munmap(const_cast<unsigned char*>(data), static_cast<size_t>(size));
+#endif
+        data = nullptr;
+        size = 0;
+    }
+
+    bool IsOpen() const { return data != nullptr; }
+
+    const ClipCacheFormat::Header& GetHeader() const { return *At<ClipCacheFormat::Header>(0); }
+
+    uint32_t BoneCount() const { return GetHeader().boneCount; }
+    uint32_t ClipCount() const { return GetHeader().clipCount; }
+    uint32_t ChannelCount() const { return GetHeader().channelCount; }
+
+    const ClipCacheFormat::Bone& GetBone(uint32_t index) const {
+        return At<ClipCacheFormat::Bone>(GetHeader().boneTableOffset)[index];
+    }
+
+    const ClipCacheFormat::Clip& GetClip(uint32_t index) const {
+        return At<ClipCacheFormat::Clip>(GetHeader().clipTableOffset)[index];
+    }
+
+    const ClipCacheFormat::Channel& GetChannel(uint32_t index) const {
+        return At<ClipCacheFormat::Channel>(GetHeader().channelTableOffset)[index];
+    }
+
+    const char* Name(uint32_t nameOffset) const {
+        return At<char>(GetHeader().stringTableOffset + nameOffset);
+    }
+
+    const int64_t* Times(const ClipCacheFormat::Channel& channel) const { return At<int64_t>(channel.timesOffset); }
+    const float* Values(const ClipCacheFormat::Channel& channel) const { return At<float>(channel.valuesOffset); }
+};
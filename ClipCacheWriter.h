@@ -0,0 +1,191 @@
+#pragma once
+
+// Lays out and writes the clip cache format described in ClipCache.h. Takes plain bone and
+// channel data so it stays independent of the FBX SDK; FBXProcessor.h gathers it from a scene.
+
+#include "AnimationBuffer.h"
+#include "ClipCache.h"
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <system_error>
+#include <vector>
+
+namespace ClipCacheWriter {
+
+struct Bone {
+    std::string name;
+    int32_t parentIndex = -1;
+    float translation[3] = { 0.0f, 0.0f, 0.0f };
+    float rotation[3] = { 0.0f, 0.0f, 0.0f };
+    float scaling[3] = { 1.0f, 1.0f, 1.0f };
+    uint32_t rotationOrder = 0;
+    float preRotation[3] = { 0.0f, 0.0f, 0.0f };
+    float postRotation[3] = { 0.0f, 0.0f, 0.0f };
+    float rotationOffset[3] = { 0.0f, 0.0f, 0.0f };
+    float rotationPivot[3] = { 0.0f, 0.0f, 0.0f };
+    float scalingOffset[3] = { 0.0f, 0.0f, 0.0f };
+    float scalingPivot[3] = { 0.0f, 0.0f, 0.0f };
+};
+
+struct Channel {
+    uint32_t boneIndex = 0;
+    uint16_t property = ClipCacheFormat::Translation;
+    uint16_t component = 0;
+    uint32_t layerIndex = 0;
+    AnimationChannel keys;
+};
+
+struct Clip {
+    std::string name;
+    int64_t startTime = 0;
+    int64_t stopTime = 0;
+    std::vector<Channel> channels;
+};
+
+// Bones must be ordered so that every parent comes before its children.
+struct Content {
+    std::vector<Bone> bones;
+    std::vector<Clip> clips;
+};
+
+// Lays out the whole file in memory.
+inline std::vector<unsigned char> Serialize(const Content& content) {
+    using namespace ClipCacheFormat;
+
+    std::string strings(1, '\0');
+    auto AddString = [&](const std::string& text) {
+        uint32_t offset = static_cast<uint32_t>(strings.size());
+        strings += text;
+        strings += '\0';
+        return offset;
+    };
+
+    uint32_t channelCount = 0;
+    for (const Clip& clip : content.clips) {
+        channelCount += static_cast<uint32_t>(clip.channels.size());
+    }
+
+    Header header = {};
+    std::memcpy(header.magic, Magic, sizeof(Magic));
+    header.version = Version;
+    header.headerSize = sizeof(Header);
+    header.boneCount = static_cast<uint32_t>(content.bones.size());
+    header.clipCount = static_cast<uint32_t>(content.clips.size());
+    header.channelCount = channelCount;
+
+    std::vector<ClipCacheFormat::Bone> boneTable;
+    for (const Bone& bone : content.bones) {
+        ClipCacheFormat::Bone record = {};
+        record.nameOffset = AddString(bone.name);
+        record.parentIndex = bone.parentIndex;
+        std::memcpy(record.translation, bone.translation, sizeof(record.translation));
+        std::memcpy(record.rotation, bone.rotation, sizeof(record.rotation));
+        std::memcpy(record.scaling, bone.scaling, sizeof(record.scaling));
+        record.rotationOrder = bone.rotationOrder;
+        std::memcpy(record.preRotation, bone.preRotation, sizeof(record.preRotation));
+        std::memcpy(record.postRotation, bone.postRotation, sizeof(record.postRotation));
+        std::memcpy(record.rotationOffset, bone.rotationOffset, sizeof(record.rotationOffset));
+        std::memcpy(record.rotationPivot, bone.rotationPivot, sizeof(record.rotationPivot));
+        std::memcpy(record.scalingOffset, bone.scalingOffset, sizeof(record.scalingOffset));
+        std::memcpy(record.scalingPivot, bone.scalingPivot, sizeof(record.scalingPivot));
+        boneTable.push_back(record);
+    }
+
+    std::vector<ClipCacheFormat::Clip> clipTable;
+    std::vector<ClipCacheFormat::Channel> channelTable;
+    for (const Clip& clip : content.clips) {
+        ClipCacheFormat::Clip record = {};
+        record.nameOffset = AddString(clip.name);
+        record.firstChannel = static_cast<uint32_t>(channelTable.size());
+        record.channelCount = static_cast<uint32_t>(clip.channels.size());
+        record.startTime = clip.startTime;
+        record.stopTime = clip.stopTime;
+        clipTable.push_back(record);
+
+        for (const Channel& channel : clip.channels) {
+            ClipCacheFormat::Channel channelRecord = {};
+            channelRecord.boneIndex = channel.boneIndex;
+            channelRecord.property = channel.property;
+            channelRecord.component = channel.component;
+            channelRecord.layerIndex = channel.layerIndex;
+            channelRecord.keyCount = static_cast<uint32_t>(channel.keys.Size());
+            channelTable.push_back(channelRecord);
+        }
+    }
+
+    header.boneTableOffset = Align(sizeof(Header), TableAlignment);
+    header.clipTableOffset = Align(header.boneTableOffset + boneTable.size() * sizeof(ClipCacheFormat::Bone), TableAlignment);
+    header.channelTableOffset = Align(header.clipTableOffset + clipTable.size() * sizeof(ClipCacheFormat::Clip), TableAlignment);
+    header.stringTableOffset = header.channelTableOffset + channelTable.size() * sizeof(ClipCacheFormat::Channel);
+    header.stringTableSize = strings.size();
+
+    uint64_t offset = header.stringTableOffset + header.stringTableSize;
+    size_t channelIndex = 0;
+    for (const Clip& clip : content.clips) {
+        for (const Channel& channel : clip.channels) {
+            ClipCacheFormat::Channel& record = channelTable[channelIndex++];
+            record.timesOffset = Align(offset, KeyAlignment);
+            record.valuesOffset = Align(record.timesOffset + channel.keys.Size() * sizeof(int64_t), KeyAlignment);
+            offset = record.valuesOffset + channel.keys.Size() * sizeof(float);
+        }
+    }
+    header.fileSize = offset;
+
+    std::vector<unsigned char> buffer(header.fileSize, 0);
+    std::memcpy(buffer.data(), &header, sizeof(header));
+    if (!boneTable.empty()) {
+        std::memcpy(buffer.data() + header.boneTableOffset, boneTable.data(), boneTable.size() * sizeof(ClipCacheFormat::Bone));
+    }
+    if (!clipTable.empty()) {
+        std::memcpy(buffer.data() + header.clipTableOffset, clipTable.data(), clipTable.size() * sizeof(ClipCacheFormat::Clip));
+    }
+    if (!channelTable.empty()) {
+        std::memcpy(buffer.data() + header.channelTableOffset, channelTable.data(), channelTable.size() * sizeof(ClipCacheFormat::Channel));
+    }
+    std::memcpy(buffer.data() + header.stringTableOffset, strings.data(), strings.size());
+
+    channelIndex = 0;
+    for (const Clip& clip : content.clips) {
+        for (const Channel& channel : clip.channels) {
+            const ClipCacheFormat::Channel& record = channelTable[channelIndex++];
+            if (channel.keys.Size() == 0) continue;
+            std::memcpy(buffer.data() + record.timesOffset, channel.keys.times.data(), channel.keys.Size() * sizeof(int64_t));
+            std::memcpy(buffer.data() + record.valuesOffset, channel.keys.values.data(), channel.keys.Size() * sizeof(float));
+        }
+    }
+    return buffer;
+}
+
+// Writes the serialized file through a temporary file renamed into place.
+// Returns the number of bytes written, or 0 with error set.
+inline uint64_t Write(const Content& content, const std::filesystem::path& path, std::string& error) {
+    std::vector<unsigned char> buffer = Serialize(content);
+
+    std::filesystem::path tempPath = path;
+    tempPath += ".tmp";
+    {
+        std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+        file.write(reinterpret_cast<const char*>(buffer.data()), static_cast<std::streamsize>(buffer.size()));
+        if (!file) {
+            error = "Failed to write clip cache: " + tempPath.string();
+            file.close();
+            std::error_code removeError;
+            std::filesystem::remove(tempPath, removeError);
+            return 0;
+        }
+    }
+
+    std::error_code renameError;
+    std::filesystem::rename(tempPath, path, renameError);
+    if (renameError) {
+        error = "Failed to move clip cache into place: " + path.string() + " (" + renameError.message() + ")";
+        std::filesystem::remove(tempPath, renameError);
+        return 0;
+    }
+    return buffer.size();
+}
+
+} // namespace ClipCacheWriter
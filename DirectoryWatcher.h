@@ -0,0 +1,292 @@
+#pragma once
+
+// Watch-folder support for --watch: finds .fbx files that are new or changed in a directory
+// and reports each one once it has stopped growing, plus the status record the service writes.
+// Linux uses inotify; other platforms rescan the directory on every poll. Nothing here depends
+// on the FBX SDK.
+
+#include "Metrics.h"
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <map>
+#include <mutex>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#if defined(__linux__)
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+class DirectoryWatcher {
+private:
+    struct FileState {
+        std::uintmax_t size = 0;
+        int64_t modifiedTime = 0;
+        std::chrono::steady_clock::time_point changedAt;
+    };
+
+    std::filesystem::path directory;
+    std::chrono::milliseconds settleTime;
+    // files seen changing, waiting for their size and time to hold still
+    std::map<std::string, FileState> pending;
+    // what each file looked like when it was last reported, so a rescan doesn't report it again
+    std::map<std::string, std::pair<std::uintmax_t, int64_t>> reported;
+    bool rescan = true;
+#if defined(__linux__)
+    int inotifyFd = -1;
+#endif
+
+    static bool IsInput(const std::string& name) {
+        return std::filesystem::path(name).extension() == ".fbx";
+    }
+
+    static bool Stat(const std::filesystem::path& path, std::uintmax_t& size, int64_t& modifiedTime) {
+        std::error_code error;
+        if (!std::filesystem::is_regular_file(path, error)) return false;
+        size = std::filesystem::file_size(path, error);
+        if (error) return false;
+        modifiedTime = static_cast<int64_t>(std::filesystem::last_write_time(path, error).time_since_epoch().count());
+        return !error;
+    }
+
+    void Touch(const std::string& name, std::chrono::steady_clock::time_point now) {
+        std::uintmax_t size;
+        int64_t modifiedTime;
+        if (!Stat(directory / name, size, modifiedTime)) {
+            pending.erase(name);
+            return;
+        }
+
+        auto previous = reported.find(name);
+        if (previous != reported.end() && previous->second == std::make_pair(size, modifiedTime)) return;
+
+        FileState& state = pending[name];
+        if (state.changedAt == std::chrono::steady_clock::time_point() || state.size != size ||
+            state.modifiedTime != modifiedTime) {
+            state.size = size;
+            state.modifiedTime = modifiedTime;
+            state.changedAt = now;
+        }
+    }
+
+    void Rescan(std::chrono::steady_clock::time_point now) {
+        std::error_code error;
+        for (const auto& entry : std::filesystem::directory_iterator(directory, error)) {
+            std::string name = entry.path().filename().string();
+            if (IsInput(name)) Touch(name, now);
+        }
+        rescan = false;
+    }
+
+#if defined(__linux__)
+    // Drains queued inotify events; false when the watched directory itself went away.
+    bool ReadEvents(std::chrono::steady_clock::time_point now) {
+        alignas(inotify_event) char buffer[16384];
+        while (true) {
+            ssize_t length = read(inotifyFd, buffer, sizeof(buffer));
+            if (length <= 0) return true;
+
+            for (char* cursor = buffer; cursor < buffer + length;) {
+                const inotify_event* event = reinterpret_cast<const inotify_event*>(cursor);
+                cursor += sizeof(inotify_event) + event->len;
+
+                if (event->mask & IN_Q_OVERFLOW) rescan = true;
+                if (event->mask & (IN_DELETE_SELF | IN_MOVE_SELF | IN_IGNORED)) return false;
+                if (event->len > 0 && IsInput(event->name)) Touch(event->name, now);
+            }
+        }
+    }
+#endif
+
+public:
+    DirectoryWatcher(const std::filesystem::path& directory, std::chrono::milliseconds settleTime)
+        : directory(directory), settleTime(settleTime) {}
+
+    ~DirectoryWatcher() {
+#if defined(__linux__)
+        if (inotifyFd >= 0) close(inotifyFd);
+#endif
+    }
+
+    DirectoryWatcher(const DirectoryWatcher&) = delete;
+    DirectoryWatcher& operator=(const DirectoryWatcher&) = delete;
+
+    bool Start(std::string& error) {
+        std::error_code statusError;
+        if (!std::filesystem::is_directory(directory, statusError)) {
+            error = "Not a directory: " + directory.string();
+            return false;
+        }
+#if defined(__linux__)
+        inotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        uint32_t mask = IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE | IN_MODIFY | IN_ATTRIB | IN_DELETE_SELF | IN_MOVE_SELF;
+        if (inotifyFd < 0 || inotify_add_watch(inotifyFd, directory.c_str(), mask) < 0) {
+            error = "Failed to watch directory: " + directory.string();
+            return false;
+        }
+#endif
+        // the first poll picks up whatever is already there
+        rescan = true;
+        return true;
+    }
+
+    // Waits up to timeout for changes and returns the names of .fbx files whose size and
+    // modification time have held still for the settle time. Each version of a file is
+    // reported once. Returns false when the directory can no longer be watched.
+    bool Poll(std::chrono::milliseconds timeout, std::vector<std::string>& stableFiles) {
+        stableFiles.clear();
+#if defined(__linux__)
+        pollfd descriptor = { inotifyFd, POLLIN, 0 };
+        if (poll(&descriptor, 1, static_cast<int>(timeout.count())) > 0 && !ReadEvents(std::chrono::steady_clock::now())) {
+            return false;
+        }
+#else
+        std::this_thread::sleep_for(timeout);
+        rescan = true;
+#endif
+        auto now = std::chrono::steady_clock::now();
+        if (rescan) Rescan(now);
+
+        for (auto it = pending.begin(); it != pending.end();) {
+            FileState& state = it->second;
+            std::uintmax_t size;
+            int64_t modifiedTime;
+            if (!Stat(directory / it->first, size, modifiedTime)) {
+                it = pending.erase(it);
+                continue;
+            }
+
+            if (size != state.size || modifiedTime != state.modifiedTime) {
+                state.size = size;
+                state.modifiedTime = modifiedTime;
+                state.changedAt = now;
+            } else if (now - state.changedAt >= settleTime) {
+                reported[it->first] = std::make_pair(size, modifiedTime);
+                stableFiles.push_back(it->first);
+                it = pending.erase(it);
+                continue;
+            }
+            ++it;
+        }
+        return true;
+    }
+
+    // Hands a reported file back; it is reported again after another settle period.
+    void Defer(const std::string& name) {
+        reported.erase(name);
+        Touch(name, std::chrono::steady_clock::now());
+    }
+};
+
+// Counters the watch service keeps while running, written to its status file.
+class WatchStatus {
+private:
+    std::mutex mutex;
+    // serializes WriteFile, which workers and the watcher both call
+    std::mutex fileMutex;
+    std::chrono::steady_clock::time_point started = std::chrono::steady_clock::now();
+    // completion times inside the recent throughput window
+    std::deque<std::chrono::steady_clock::time_point> recent;
+    int workers = 0;
+    size_t queued = 0;
+    size_t active = 0;
+    uint64_t processed = 0;
+    uint64_t failed = 0;
+    uint64_t upToDate = 0;
+    uint64_t actorsExported = 0;
+    uint64_t inputBytes = 0;
+    std::string lastFile;
+    std::string lastError;
+
+public:
+    static constexpr std::chrono::seconds RecentWindow{300};
+
+    explicit WatchStatus(int workers) : workers(workers) {}
+
+    void Queued() {
+        std::lock_guard<std::mutex> lock(mutex);
+        queued++;
+    }
+
+    // Takes back Queued() for a file the full queue turned away.
+    void Unqueued() {
+        std::lock_guard<std::mutex> lock(mutex);
+        queued--;
+    }
+
+    void Started() {
+        std::lock_guard<std::mutex> lock(mutex);
+        queued--;
+        active++;
+    }
+
+    void Finished(const std::string& file, bool rebuilt, bool success, int actors, uint64_t bytes, const std::string& error) {
+        std::lock_guard<std::mutex> lock(mutex);
+        active--;
+        lastFile = file;
+        if (!rebuilt) {
+            upToDate++;
+            return;
+        }
+
+        auto now = std::chrono::steady_clock::now();
+        processed++;
+        actorsExported += actors;
+        inputBytes += bytes;
+        recent.push_back(now);
+        if (!success) {
+            failed++;
+            lastError = file + ": " + error;
+        }
+    }
+
+    void WriteJson(std::ostream& out, const std::string& directoryPath, bool running) {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto now = std::chrono::steady_clock::now();
+        while (!recent.empty() && now - recent.front() > RecentWindow) recent.pop_front();
+
+        double uptimeSeconds = std::chrono::duration<double>(now - started).count();
+        double windowSeconds = std::min(uptimeSeconds, static_cast<double>(RecentWindow.count()));
+
+        out << std::fixed << std::setprecision(3);
+        out << "{\n  \"directory\": \"" << MetricsWriter::EscapeJson(directoryPath) << "\",\n";
+        out << "  \"running\": " << (running ? "true" : "false") << ",\n";
+        out << "  \"uptime_s\": " << uptimeSeconds << ",\n";
+        out << "  \"workers\": " << workers << ",\n";
+        out << "  \"queue_depth\": " << queued << ",\n";
+        out << "  \"active\": " << active << ",\n";
+        out << "  \"processed\": " << processed << ",\n";
+        out << "  \"failed\": " << failed << ",\n";
+        out << "  \"up_to_date\": " << upToDate << ",\n";
+        out << "  \"actors_exported\": " << actorsExported << ",\n";
+        out << "  \"input_bytes\": " << inputBytes << ",\n";
+        out << "  \"files_per_minute\": " << (uptimeSeconds > 0.0 ? processed * 60.0 / uptimeSeconds : 0.0) << ",\n";
+        out << "  \"recent_files_per_minute\": " << (windowSeconds > 0.0 ? recent.size() * 60.0 / windowSeconds : 0.0) << ",\n";
+        out << "  \"input_mb_per_s\": " << (uptimeSeconds > 0.0 ? inputBytes / (1024.0 * 1024.0) / uptimeSeconds : 0.0) << ",\n";
+        out << "  \"last_file\": \"" << MetricsWriter::EscapeJson(lastFile) << "\",\n";
+        out << "  \"last_error\": \"" << MetricsWriter::EscapeJson(lastError) << "\"\n}\n";
+    }
+
+    // Written through a temporary file so readers never see a partial status.
+    bool WriteFile(const std::filesystem::path& path, const std::string& directoryPath, bool running) {
+        std::lock_guard<std::mutex> lock(fileMutex);
+        std::filesystem::path tempPath = path;
+        tempPath += ".tmp";
+        {
+            std::ofstream file(tempPath, std::ios::trunc);
+            WriteJson(file, directoryPath, running);
+            if (!file) return false;
+        }
+        std::error_code renameError;
+        std::filesystem::rename(tempPath, path, renameError);
+        return !renameError;
+    }
+};
@@ -0,0 +1,2437 @@
+#pragma once
+
+#include <fbxsdk.h>
+#include "AnimationBuffer.h"
+#include "ClipCacheWriter.h"
+#include "DirectoryWatcher.h"
+#include "Manifest.h"
+#include "MemoryStream.h"
+#include "MemoryUsage.h"
+#include "Metrics.h"
+#include "SceneReport.h"
+#include <iostream>
+#include <limits>
+#include <string>
+#include <vector>
+#include <filesystem>
+#include <fstream>
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <unordered_map>
+#include <unordered_set>
+#include <memory>
+#include <thread>
+
+namespace fs = std::filesystem;
+
+inline std::mutex logMutex;
+// drops LogInfo progress lines; errors and LogAlways output are still written
+inline std::atomic<bool> quietLogging{false};
+
+// Whole-line writes so output from parallel workers doesn't interleave mid-line. Lines are
+// not flushed individually, which matters on batches with thousands of actors.
+inline void LogAlways(const std::string& message) {
+    std::lock_guard<std::mutex> lock(logMutex);
+    std::cout << message << '\n';
+}
+
+inline void LogInfo(const std::string& message) {
+    if (quietLogging) return;
+    LogAlways(message);
+}
+
+inline void LogError(const std::string& message) {
+    std::lock_guard<std::mutex> lock(logMutex);
+    std::cerr << message << '\n';
+}
+
+using SkinnedMeshIndex = std::unordered_map<FbxNode*, std::vector<FbxNode*>>;
+
+// Flattened scene graph built in one pass over the scene. Nodes are in depth-first order, so a
+// parent always precedes its children and each subtree is the contiguous range
+// [i, subtreeEnd[i]). Extraction, skinned mesh lookup and source release all walk these ranges.
+struct SceneIndex {
+    std::vector<FbxNode*> nodes;
+    // -1 for the scene root
+    std::vector<int> parents;
+    // eUnknown for nodes without an attribute
+    std::vector<FbxNodeAttribute::EType> attributeTypes;
+    // skeleton nodes with no skeleton ancestor
+    std::vector<char> skeletonRoots;
+    std::vector<int> subtreeEnd;
+    std::unordered_map<FbxNode*, int> indexOf;
+
+    int IndexOf(FbxNode* node) const {
+        auto it = indexOf.find(node);
+        return it != indexOf.end() ? it->second : -1;
+    }
+
+    std::vector<FbxNode*> SkeletonRoots() const {
+        std::vector<FbxNode*> roots;
+        for (size_t i = 0; i < nodes.size(); i++) {
+            if (skeletonRoots[i]) roots.push_back(nodes[i]);
+        }
+        return roots;
+    }
+};
+
+// Global matrices of a set of bones at every sampled frame of one animation stack, frame-major in
+// one contiguous array. Bones keep scene index order, so each parent is computed before its children.
+struct GlobalTransformCache {
+    std::vector<FbxNode*> bones;
+    // index into bones; -1 when the parent is not cached
+    std::vector<int> parents;
+    std::vector<FbxTime> times;
+    std::vector<FbxAMatrix> globals;
+
+    size_t FrameCount() const { return times.size(); }
+
+    const FbxAMatrix& Global(size_t frame, size_t bone) const { return globals[frame * bones.size() + bone]; }
+
+    int BoneIndex(FbxNode* node) const {
+        auto it = std::find(bones.begin(), bones.end(), node);
+        return it != bones.end() ? static_cast<int>(it - bones.begin()) : -1;
+    }
+};
+
+// Source-to-clone bookkeeping for one ExtractSkeleton call.
+struct CloneContext {
+    std::unordered_map<FbxNode*, FbxNode*> nodes;
+    // the same pairs in clone order, parents before children
+    std::vector<std::pair<FbxNode*, FbxNode*>> nodePairs;
+    std::unordered_map<FbxSurfaceMaterial*, FbxSurfaceMaterial*> materials;
+    std::vector<std::pair<FbxMesh*, FbxMesh*>> meshes;
+};
+
+struct ProcessingOptions {
+    bool rotateToFaceZ = false;
+    int jobs = 1;
+    // overlap export of actor N with extraction of actor N+1
+    bool pipeline = false;
+    // upper bound on extracted scenes alive at once in pipelined mode
+    int maxLiveScenes = 2;
+    // rebuild inputs even when the manifest says they are up to date
+    bool force = false;
+    // only report what would be rebuilt
+    bool dryRun = false;
+    // skip unused import categories and free source data as soon as each actor is extracted
+    bool lowMemory = false;
+    // reset the process's peak RSS before each file so it is reported per file (Linux, jobs <= 1);
+    // this touches process-wide state, so embedding applications leave it off
+    bool resetPeakRss = false;
+    // drop keys that linear interpolation reproduces within tolerance before export
+    bool reduceKeys = false;
+    // scene units
+    double translationTolerance = 0.01;
+    // degrees
+    double rotationTolerance = 0.1;
+    // write FBX ascii instead of the SDK's native binary format
+    bool asciiOutput = false;
+    // e.g. "FBX201800"; empty writes the SDK's own version
+    std::string fbxVersion;
+    // embed referenced media in binary outputs
+    bool embedMedia = false;
+    // zlib level for binary array compression: 0 turns it off, -1 keeps the SDK default
+    int compressionLevel = -1;
+    // also write each actor as a .fbxclip cache (ClipCache.h) next to its .fbx
+    bool clipCache = false;
+    
+    // Options that change the produced files; a different key forces a rebuild.
+    std::string ManifestKey() const {
+        std::string key = std::string("rotateToFaceZ=") + (rotateToFaceZ ? "1" : "0") +
+                          ",lowMemory=" + (lowMemory ? "1" : "0");
+        if (reduceKeys) {
+            key += ",reduce=" + std::to_string(translationTolerance) + "/" + std::to_string(rotationTolerance);
+        }
+        if (asciiOutput) key += ",ascii=1";
+        if (!fbxVersion.empty()) key += ",version=" + fbxVersion;
+        if (embedMedia) key += ",embed=1";
+        if (compressionLevel >= 0) key += ",compression=" + std::to_string(compressionLevel);
+        if (clipCache) key += ",clipCache=1";
+        return key;
+    }
+};
+
+// Settings for --watch that don't affect the produced files.
+struct WatchOptions {
+    // written after every file and on each poll; empty means <directory>/.fbxprocessor-status.json
+    std::string statusPath;
+    // files waiting for a worker; files that find it full are retried after another settle period
+    size_t queueCapacity = 16;
+    // how long a file's size and time must hold still before it is processed
+    std::chrono::milliseconds settleTime{2000};
+    std::chrono::milliseconds pollInterval{500};
+};
+
+// One output of ProcessBuffer, named like the file ProcessFile would write.
+struct OutputBuffer {
+    std::string fileName;
+    std::vector<char> bytes;
+};
+
+struct FileResult {
+    std::string inputFilePath;
+    bool success = false;
+    int exportedActors = 0;
+    int failedActors = 0;
+    std::string error;
+    // file names of the outputs written, relative to the input's directory; a failed actor's
+    // .fbx is listed when only its clip cache failed
+    std::vector<std::string> outputs;
+    // peak resident set size while this file was processed (process-wide when not resettable)
+    std::uintmax_t peakRssBytes = 0;
+    FileMetrics metrics;
+    // the outputs themselves, in the same order, when processed by ProcessBuffer
+    std::vector<OutputBuffer> buffers;
+};
+
+// Blocking FIFO with a fixed capacity; Pop returns false once the queue is closed and drained.
+template <typename T>
+class BoundedQueue {
+private:
+    std::mutex mutex;
+    std::condition_variable notEmpty;
+    std::condition_variable notFull;
+    std::deque<T> items;
+    size_t capacity;
+    bool closed = false;
+
+public:
+    explicit BoundedQueue(size_t capacity) : capacity(std::max<size_t>(1, capacity)) {}
+
+    void Push(T item) {
+        std::unique_lock<std::mutex> lock(mutex);
+        notFull.wait(lock, [&]() { return items.size() < capacity; });
+        items.push_back(std::move(item));
+        notEmpty.notify_one();
+    }
+
+    // Push that gives up instead of waiting when the queue is full.
+    bool TryPush(T item) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (items.size() >= capacity) return false;
+        items.push_back(std::move(item));
+        notEmpty.notify_one();
+        return true;
+    }
+
+    bool Pop(T& item) {
+        std::unique_lock<std::mutex> lock(mutex);
+        notEmpty.wait(lock, [&]() { return !items.empty() || closed; });
+        if (items.empty()) return false;
+        item = std::move(items.front());
+        items.pop_front();
+        notFull.notify_one();
+        return true;
+    }
+
+    void Close() {
+        std::lock_guard<std::mutex> lock(mutex);
+        closed = true;
+        notEmpty.notify_all();
+    }
+};
+
+class FBXProcessor {
+private:
+    // times the individual stages below (bench/fbx_bench.cpp)
+    friend class StageBenchmark;
+    
+    // Threading: the SDK is not thread-safe, so every FbxManager (with all of its objects) is
+    // only ever used by one thread at a time. fbxManager belongs to the thread calling into this
+    // processor. In pipelined mode each extracted scene lives in one of pipelineManagers instead,
+    // and the manager is handed to the export thread together with the scene and handed back
+    // once the scene is destroyed, so the two threads never touch the same manager.
+    FbxManager* fbxManager;
+    std::vector<FbxManager*> pipelineManagers;
+
+    // the SDK's plugin registry is global, so managers are created and destroyed one at a time
+    static std::mutex& ManagerMutex() {
+        static std::mutex mutex;
+        return mutex;
+    }
+    
+    static FbxManager* CreateManager() {
+        std::lock_guard<std::mutex> lock(ManagerMutex());
+        FbxManager* manager = FbxManager::Create();
+        
+        FbxIOSettings* ios = FbxIOSettings::Create(manager, IOSROOT);
+        manager->SetIOSettings(ios);
+        return manager;
+    }
+    
+    // writer and file version chosen by ConfigureExport; binary with the SDK's version until then
+    int exportFormat = -1;
+    std::string exportVersion;
+    bool writeClipCache = false;
+    
+    FbxScene* CreateNewScene(FbxManager* manager) {
+        FbxScene* scene = FbxScene::Create(manager, "");
+        return scene;
+    }
+
+    std::string GetActorNameFromNode(FbxNode* node) {
+        std::string nodeName = node->GetName();
+        for (size_t i = 0; i < nodeName.length(); i++) {
+            if (!std::isalnum(nodeName[i])) {
+                nodeName[i] = '_';
+            }
+        }
+        return nodeName;
+    }
+    
+    SceneIndex BuildSceneIndex(FbxScene* scene) {
+        SceneIndex index;
+        int nodeCount = scene->GetNodeCount();
+        index.nodes.reserve(nodeCount);
+        index.parents.reserve(nodeCount);
+        index.attributeTypes.reserve(nodeCount);
+        index.skeletonRoots.reserve(nodeCount);
+        index.indexOf.reserve(nodeCount);
+        
+        // node or one of its ancestors is a skeleton
+        std::vector<char> inSkeleton;
+        
+        // children are pushed in reverse so they are visited in their original order
+        std::vector<std::pair<FbxNode*, int>> stack = { { scene->GetRootNode(), -1 } };
+        while (!stack.empty()) {
+            FbxNode* node = stack.back().first;
+            int parent = stack.back().second;
+            stack.pop_back();
+            
+            int nodeIndex = static_cast<int>(index.nodes.size());
+            FbxNodeAttribute* attribute = node->GetNodeAttribute();
+            FbxNodeAttribute::EType attributeType = attribute ? attribute->GetAttributeType() : FbxNodeAttribute::eUnknown;
+            bool isSkeleton = attributeType == FbxNodeAttribute::eSkeleton;
+            bool parentInSkeleton = parent >= 0 && inSkeleton[parent];
+            
+            index.nodes.push_back(node);
+            index.parents.push_back(parent);
+            index.attributeTypes.push_back(attributeType);
+            index.skeletonRoots.push_back(isSkeleton && !parentInSkeleton);
+            index.indexOf[node] = nodeIndex;
+            inSkeleton.push_back(isSkeleton || parentInSkeleton);
+            
+            for (int i = node->GetChildCount() - 1; i >= 0; i--) {
+                stack.emplace_back(node->GetChild(i), nodeIndex);
+            }
+        }
+        
+        // children always come after their parent, so one backwards pass settles every range
+        index.subtreeEnd.resize(index.nodes.size());
+        for (int i = static_cast<int>(index.nodes.size()) - 1; i >= 0; i--) {
+            index.subtreeEnd[i] = std::max(index.subtreeEnd[i], i + 1);
+            if (index.parents[i] >= 0) {
+                index.subtreeEnd[index.parents[i]] = std::max(index.subtreeEnd[index.parents[i]], index.subtreeEnd[i]);
+            }
+        }
+        
+        return index;
+    }
+    
+    // Maps each skeleton root to the mesh nodes that have a skin cluster linked to any node of
+    // that root's hierarchy. Built in one pass over the scene so ExtractSkeleton only looks up.
+    SkinnedMeshIndex BuildSkinnedMeshIndex(const SceneIndex& sceneIndex, const std::vector<FbxNode*>& skeletonRoots) {
+        SkinnedMeshIndex index;
+        
+        std::vector<FbxNode*> rootOfNode(sceneIndex.nodes.size(), nullptr);
+        for (FbxNode* root : skeletonRoots) {
+            index[root];
+            int rootIndex = sceneIndex.IndexOf(root);
+            if (rootIndex < 0) continue;
+            std::fill(rootOfNode.begin() + rootIndex, rootOfNode.begin() + sceneIndex.subtreeEnd[rootIndex], root);
+        }
+        
+        for (size_t i = 0; i < sceneIndex.nodes.size(); ++i) {
+            if (sceneIndex.attributeTypes[i] != FbxNodeAttribute::eMesh) continue;
+            
+            FbxNode* node = sceneIndex.nodes[i];
+            FbxMesh* mesh = node->GetMesh();
+            if (!mesh) continue;
+            
+            // meshes inside a skeleton hierarchy are already cloned along with it
+            FbxNode* ownerRoot = rootOfNode[i];
+            
+            std::vector<FbxNode*> linkedRoots;
+            int skinCount = mesh->GetDeformerCount(FbxDeformer::eSkin);
+            for (int skinIndex = 0; skinIndex < skinCount; ++skinIndex) {
+                FbxSkin* skin = FbxCast<FbxSkin>(mesh->GetDeformer(skinIndex, FbxDeformer::eSkin));
+                if (!skin) continue;
+                
+                for (int clusterIndex = 0; clusterIndex < skin->GetClusterCount(); ++clusterIndex) {
+                    int linkIndex = sceneIndex.IndexOf(skin->GetCluster(clusterIndex)->GetLink());
+                    FbxNode* linkedRoot = linkIndex >= 0 ? rootOfNode[linkIndex] : nullptr;
+                    if (!linkedRoot || linkedRoot == ownerRoot) continue;
+                    
+                    if (std::find(linkedRoots.begin(), linkedRoots.end(), linkedRoot) == linkedRoots.end()) {
+                        linkedRoots.push_back(linkedRoot);
+                        index[linkedRoot].push_back(node);
+                    }
+                }
+            }
+        }
+        
+        return index;
+    }
+    
+    // The new scene is created in manager, or in this processor's own manager when none is given.
+    FbxScene* ExtractSkeleton(FbxScene* originalScene, const SceneIndex& sceneIndex, FbxNode* skeletonRoot,
+                              const std::vector<FbxNode*>& skinnedMeshes, MetricsRecord* metrics = nullptr,
+                              FbxManager* manager = nullptr) {
+        FbxScene* newScene = CreateNewScene(manager ? manager : fbxManager);
+        CloneContext context;
+        FbxNode* newRoot = nullptr;
+        
+        {
+            ScopedTimer timer(metrics, "extraction");
+            
+            newScene->GetGlobalSettings().SetAxisSystem(originalScene->GetGlobalSettings().GetAxisSystem());
+            newScene->GetGlobalSettings().SetSystemUnit(originalScene->GetGlobalSettings().GetSystemUnit());
+            
+            newRoot = CloneNodeHierarchy(sceneIndex, skeletonRoot, newScene->GetRootNode(), newScene, context);
+            
+            for (FbxNode* meshNode : skinnedMeshes) {
+                CloneNodeHierarchy(sceneIndex, meshNode, newRoot, newScene, context);
+                LogInfo(std::string("  Attached mesh: ") + meshNode->GetName());
+            }
+            
+            // bones are all cloned by now, so skin clusters can be relinked
+            CloneSkins(newScene, context);
+        }
+        
+        size_t keyCount = 0;
+        {
+            ScopedTimer timer(metrics, "animation_copy");
+            keyCount = CopyAnimation(originalScene, newScene, context);
+        }
+        
+        if (metrics) {
+            metrics->AddCount("nodes", context.nodes.size());
+            metrics->AddCount("meshes", context.meshes.size());
+            metrics->AddCount("keys", keyCount);
+        }
+        
+        return newScene;
+    }
+    
+    // Clones the subtree under sourceRoot as one range of the scene index; parents are cloned
+    // before their children, so each node's parent clone already exists.
+    FbxNode* CloneNodeHierarchy(const SceneIndex& sceneIndex, FbxNode* sourceRoot, FbxNode* destParent, FbxScene* destScene,
+                                CloneContext& context) {
+        int rootIndex = sceneIndex.IndexOf(sourceRoot);
+        if (rootIndex < 0) return nullptr;
+        
+        int endIndex = sceneIndex.subtreeEnd[rootIndex];
+        std::vector<FbxNode*> clones(endIndex - rootIndex);
+        for (int i = rootIndex; i < endIndex; i++) {
+            FbxNode* parentClone = i == rootIndex ? destParent : clones[sceneIndex.parents[i] - rootIndex];
+            clones[i - rootIndex] = CloneNode(sceneIndex.nodes[i], sceneIndex.attributeTypes[i], parentClone, destScene, context);
+        }
+        
+        return clones[0];
+    }
+    
+    FbxNode* CloneNode(FbxNode* sourceNode, FbxNodeAttribute::EType attributeType, FbxNode* destParent, FbxScene* destScene,
+                       CloneContext& context) {
+        FbxNode* newNode = FbxNode::Create(destScene, sourceNode->GetName());
+        destParent->AddChild(newNode);
+        context.nodes[sourceNode] = newNode;
+        context.nodePairs.emplace_back(sourceNode, newNode);
+        
+        // the attribute can be gone when low-memory mode already released it
+        FbxNodeAttribute* originalAttribute = sourceNode->GetNodeAttribute();
+        if (attributeType != FbxNodeAttribute::eUnknown && originalAttribute) {
+            if (attributeType == FbxNodeAttribute::eSkeleton) {
+                FbxSkeleton* skeleton = FbxSkeleton::Create(destScene, "");
+                skeleton->SetSkeletonType(((FbxSkeleton*)originalAttribute)->GetSkeletonType());
+                newNode->SetNodeAttribute(skeleton);
+            } else if (attributeType == FbxNodeAttribute::eMesh) {
+                FbxMesh* originalMesh = (FbxMesh*)originalAttribute;
+                newNode->SetNodeAttribute(CloneMeshGeometry(originalMesh, destScene));
+                context.meshes.emplace_back(originalMesh, newNode->GetMesh());
+                
+                newNode->GeometricTranslation.Set(sourceNode->GeometricTranslation.Get());
+                newNode->GeometricRotation.Set(sourceNode->GeometricRotation.Get());
+                newNode->GeometricScaling.Set(sourceNode->GeometricScaling.Get());
+                
+                CloneMaterials(sourceNode, newNode, destScene, context);
+            }
+        }
+        
+        newNode->LclTranslation.Set(sourceNode->LclTranslation.Get());
+        newNode->LclRotation.Set(sourceNode->LclRotation.Get());
+        newNode->LclScaling.Set(sourceNode->LclScaling.Get());
+        
+        return newNode;
+    }
+    
+    // FbxMesh::Copy moves control points, polygon/vertex index arrays, edges and every layer
+    // element (normals, UVs, colors, material indices...) as whole arrays. Deformers are
+    // connections rather than content and are rebuilt against the cloned bones by CloneSkins.
+    FbxMesh* CloneMeshGeometry(FbxMesh* originalMesh, FbxScene* destScene) {
+        FbxMesh* newMesh = FbxMesh::Create(destScene, originalMesh->GetName());
+        newMesh->Copy(*originalMesh);
+        
+        for (int i = newMesh->GetDeformerCount() - 1; i >= 0; i--) {
+            newMesh->RemoveDeformer(i);
+        }
+        
+        return newMesh;
+    }
+    
+    // Materials shared between meshes of the same actor are cloned once per extracted scene.
+    void CloneMaterials(FbxNode* sourceNode, FbxNode* newNode, FbxScene* destScene, CloneContext& context) {
+        for (int i = 0; i < sourceNode->GetMaterialCount(); i++) {
+            FbxSurfaceMaterial* material = sourceNode->GetMaterial(i);
+            if (!material) continue;
+            
+            FbxSurfaceMaterial*& clone = context.materials[material];
+            if (!clone) {
+                clone = FbxCast<FbxSurfaceMaterial>(material->Clone(FbxObject::eDeepClone, destScene));
+            }
+            if (clone) {
+                newNode->AddMaterial(clone);
+            }
+        }
+    }
+    
+    // Rebuilds each cloned mesh's FbxSkin/FbxCluster deformers with links pointing at the cloned
+    // bones, copying influence arrays in bulk and carrying the bind matrices over into a bind pose.
+    // Clusters linked to bones outside the extracted hierarchy are dropped.
+    void CloneSkins(FbxScene* destScene, const CloneContext& context) {
+        FbxPose* bindPose = nullptr;
+        
+        for (const auto& meshPair : context.meshes) {
+            FbxMesh* sourceMesh = meshPair.first;
+            FbxMesh* destMesh = meshPair.second;
+            
+            int skinCount = sourceMesh->GetDeformerCount(FbxDeformer::eSkin);
+            for (int skinIndex = 0; skinIndex < skinCount; skinIndex++) {
+                FbxSkin* sourceSkin = FbxCast<FbxSkin>(sourceMesh->GetDeformer(skinIndex, FbxDeformer::eSkin));
+                if (!sourceSkin) continue;
+                
+                FbxSkin* destSkin = FbxSkin::Create(destScene, sourceSkin->GetName());
+                destSkin->SetSkinningType(sourceSkin->GetSkinningType());
+                destSkin->SetDeformAccuracy(sourceSkin->GetDeformAccuracy());
+                
+                for (int clusterIndex = 0; clusterIndex < sourceSkin->GetClusterCount(); clusterIndex++) {
+                    FbxCluster* sourceCluster = sourceSkin->GetCluster(clusterIndex);
+                    auto link = context.nodes.find(sourceCluster->GetLink());
+                    if (link == context.nodes.end()) continue;
+                    
+                    FbxCluster* destCluster = FbxCluster::Create(destScene, sourceCluster->GetName());
+                    destCluster->SetLink(link->second);
+                    destCluster->SetLinkMode(sourceCluster->GetLinkMode());
+                    
+                    int influenceCount = sourceCluster->GetControlPointIndicesCount();
+                    destCluster->SetControlPointIWCount(influenceCount);
+                    if (influenceCount > 0) {
+                        std::copy_n(sourceCluster->GetControlPointIndices(), influenceCount, destCluster->GetControlPointIndices());
+                        std::copy_n(sourceCluster->GetControlPointWeights(), influenceCount, destCluster->GetControlPointWeights());
+                    }
+                    
+                    FbxAMatrix meshBindMatrix;
+                    FbxAMatrix boneBindMatrix;
+                    sourceCluster->GetTransformMatrix(meshBindMatrix);
+                    sourceCluster->GetTransformLinkMatrix(boneBindMatrix);
+                    destCluster->SetTransformMatrix(meshBindMatrix);
+                    destCluster->SetTransformLinkMatrix(boneBindMatrix);
+                    
+                    destSkin->AddCluster(destCluster);
+                    
+                    if (!bindPose) {
+                        bindPose = FbxPose::Create(destScene, "BindPose");
+                        bindPose->SetIsBindPose(true);
+                        destScene->AddPose(bindPose);
+                    }
+                    if (bindPose->Find(link->second) < 0) {
+                        bindPose->Add(link->second, FbxMatrix(boneBindMatrix));
+                    }
+                    FbxNode* destMeshNode = destMesh->GetNode();
+                    if (destMeshNode && bindPose->Find(destMeshNode) < 0) {
+                        bindPose->Add(destMeshNode, FbxMatrix(meshBindMatrix));
+                    }
+                }
+                
+                destMesh->AddDeformer(destSkin);
+            }
+        }
+    }
+    
+    // Copies the animation of every cloned node, paired through the clone map. Returns the number
+    // of keys copied.
+    size_t CopyAnimation(FbxScene* sourceScene, FbxScene* destScene, const CloneContext& context) {
+        size_t keyCount = 0;
+        int animStackCount = sourceScene->GetSrcObjectCount<FbxAnimStack>();
+        
+        for (int stackIndex = 0; stackIndex < animStackCount; stackIndex++) {
+            FbxAnimStack* sourceStack = sourceScene->GetSrcObject<FbxAnimStack>(stackIndex);
+            
+            FbxAnimStack* destStack = FbxAnimStack::Create(destScene, sourceStack->GetName());
+            
+            int layerCount = sourceStack->GetMemberCount<FbxAnimLayer>();
+            
+            for (int layerIndex = 0; layerIndex < layerCount; layerIndex++) {
+                FbxAnimLayer* sourceLayer = sourceStack->GetMember<FbxAnimLayer>(layerIndex);
+                FbxAnimLayer* destLayer = FbxAnimLayer::Create(destScene, sourceLayer->GetName());
+                destStack->AddMember(destLayer);
+                
+                for (const auto& nodePair : context.nodePairs) {
+                    keyCount += CopyNodeAnimation(nodePair.first, nodePair.second, sourceLayer, destLayer);
+                }
+            }
+        }
+        
+        return keyCount;
+    }
+    
+    // Copies the curves of every animated property on the node, not only the Lcl T/R/S channels.
+    // User-defined properties missing on the clone are created so custom channels survive.
+    size_t CopyNodeAnimation(FbxNode* sourceNode, FbxNode* destNode, FbxAnimLayer* sourceLayer, FbxAnimLayer* destLayer) {
+        size_t keyCount = 0;
+        for (FbxProperty sourceProperty = sourceNode->GetFirstProperty(); sourceProperty.IsValid();
+             sourceProperty = sourceNode->GetNextProperty(sourceProperty)) {
+            if (!sourceProperty.GetFlag(FbxPropertyFlags::eAnimatable)) continue;
+            
+            FbxAnimCurveNode* sourceCurveNode = sourceProperty.GetCurveNode(sourceLayer);
+            if (!sourceCurveNode) continue;
+            
+            FbxProperty destProperty = destNode->FindPropertyHierarchical(sourceProperty.GetHierarchicalName());
+            if (!destProperty.IsValid()) {
+                if (!sourceProperty.GetFlag(FbxPropertyFlags::eUserDefined)) continue;
+                
+                destProperty = FbxProperty::Create(destNode, sourceProperty.GetPropertyDataType(), sourceProperty.GetName());
+                destProperty.CopyValue(sourceProperty);
+                destProperty.ModifyFlag(FbxPropertyFlags::eUserDefined, true);
+                destProperty.ModifyFlag(FbxPropertyFlags::eAnimatable, true);
+            }
+            
+            for (unsigned int channel = 0; channel < sourceCurveNode->GetChannelsCount(); channel++) {
+                FbxAnimCurve* sourceCurve = sourceCurveNode->GetCurve(channel);
+                if (!sourceCurve) continue;
+                
+                FbxString channelName = sourceCurveNode->GetChannelName(channel);
+                keyCount += CopyAnimationCurve(sourceCurve, destProperty.GetCurve(destLayer, channelName.Buffer(), true));
+            }
+        }
+        
+        return keyCount;
+    }
+    
+    // Copies the whole key array in one bulk operation inside a modify block, which keeps
+    // interpolation, tangent, weight, velocity and constant modes along with times and values.
+    size_t CopyAnimationCurve(FbxAnimCurve* sourceCurve, FbxAnimCurve* destCurve) {
+        if (!sourceCurve || !destCurve) return 0;
+        
+        destCurve->KeyModifyBegin();
+        destCurve->CopyFrom(*sourceCurve, true);
+        destCurve->KeyModifyEnd();
+        
+        return destCurve->KeyGetCount();
+    }
+    
+    // Rotation matrix for Euler angles in degrees; eEulerXYZ applies X first, as FbxAMatrix::SetR does.
+    static FbxAMatrix EulerMatrix(const FbxVector4& degrees, EFbxRotationOrder order) {
+        FbxAMatrix x, y, z;
+        x.SetR(FbxVector4(degrees[0], 0.0, 0.0));
+        y.SetR(FbxVector4(0.0, degrees[1], 0.0));
+        z.SetR(FbxVector4(0.0, 0.0, degrees[2]));
+        
+        switch (order) {
+            case eEulerXZY: return y * z * x;
+            case eEulerYZX: return x * z * y;
+            case eEulerYXZ: return z * x * y;
+            case eEulerZXY: return y * x * z;
+            case eEulerZYX: return x * y * z;
+            default: return z * y * x;
+        }
+    }
+    
+    // The SDK's local transform, T * Roff * Rp * Rpre * R * Rpost^-1 * Rp^-1 * Soff * Sp * S * Sp^-1,
+    // from already sampled T/R/S. Pivots, offsets and pre/post rotation are taken as static.
+    FbxAMatrix ComposeLocalTransform(FbxNode* node, const FbxVector4& translation, const FbxVector4& rotation,
+                                     const FbxVector4& scaling) {
+        auto Translate = [](const FbxDouble3& value, double sign = 1.0) {
+            FbxAMatrix matrix;
+            matrix.SetT(FbxVector4(sign * value[0], sign * value[1], sign * value[2]));
+            return matrix;
+        };
+        
+        FbxAMatrix t, r, s;
+        t.SetT(translation);
+        s.SetS(scaling);
+        
+        if (node->RotationActive.Get()) {
+            EFbxRotationOrder rotationOrder;
+            node->GetRotationOrder(FbxNode::eSourcePivot, rotationOrder);
+            FbxAMatrix pre, post;
+            pre.SetR(FbxVector4(node->PreRotation.Get()));
+            post.SetR(FbxVector4(node->PostRotation.Get()));
+            r = pre * EulerMatrix(rotation, rotationOrder) * post.Inverse();
+        } else {
+            r.SetR(rotation);
+        }
+        
+        return t * Translate(node->RotationOffset.Get()) * Translate(node->RotationPivot.Get()) * r *
+               Translate(node->RotationPivot.Get(), -1.0) * Translate(node->ScalingOffset.Get()) *
+               Translate(node->ScalingPivot.Get()) * s * Translate(node->ScalingPivot.Get(), -1.0);
+    }
+    
+    // Frames per second of the scene's time mode, falling back to 30 when it has none.
+    double SceneFrameRate(FbxScene* scene) {
+        FbxGlobalSettings& settings = scene->GetGlobalSettings();
+        double frameRate = settings.GetTimeMode() == FbxTime::eCustom ? settings.GetCustomFrameRate()
+                                                                      : FbxTime::GetFrameRate(settings.GetTimeMode());
+        return frameRate > 0.0 ? frameRate : 30.0;
+    }
+    
+    // Samples the requested nodes (and their ancestors) at every frame of the stack in one
+    // parent-ordered pass. With a single layer each curve is read sequentially once and the local
+    // matrices are composed here; layered stacks fall back to the SDK's local evaluation. A null
+    // stack gives one frame of the static pose.
+    GlobalTransformCache BuildGlobalTransformCache(FbxScene* scene, const SceneIndex& sceneIndex, FbxAnimStack* animStack,
+                                                   const std::vector<FbxNode*>& nodes) {
+        GlobalTransformCache cache;
+        
+        std::vector<char> cached(sceneIndex.nodes.size(), 0);
+        for (FbxNode* node : nodes) {
+            // index 0 is the scene root, whose transform is the identity
+            for (int i = sceneIndex.IndexOf(node); i > 0 && !cached[i]; i = sceneIndex.parents[i]) {
+                cached[i] = 1;
+            }
+        }
+        std::vector<int> cacheIndexOf(sceneIndex.nodes.size(), -1);
+        for (size_t i = 0; i < sceneIndex.nodes.size(); i++) {
+            if (!cached[i]) continue;
+            cacheIndexOf[i] = static_cast<int>(cache.bones.size());
+            cache.bones.push_back(sceneIndex.nodes[i]);
+            cache.parents.push_back(sceneIndex.parents[i] >= 0 ? cacheIndexOf[sceneIndex.parents[i]] : -1);
+        }
+        
+        FbxAnimLayer* layer = nullptr;
+        bool sdkEvaluation = false;
+        if (animStack) {
+            FbxTimeSpan timeSpan = animStack->GetLocalTimeSpan();
+            double frameRate = SceneFrameRate(scene);
+            
+            double start = timeSpan.GetStart().GetSecondDouble();
+            double duration = std::max(0.0, timeSpan.GetDuration().GetSecondDouble());
+            size_t frameCount = static_cast<size_t>(duration * frameRate) + 1;
+            cache.times.resize(frameCount);
+            for (size_t frame = 0; frame < frameCount; frame++) {
+                cache.times[frame].SetSecondDouble(start + frame / frameRate);
+            }
+            
+            int layerCount = animStack->GetMemberCount<FbxAnimLayer>();
+            layer = layerCount > 0 ? animStack->GetMember<FbxAnimLayer>(0) : nullptr;
+            sdkEvaluation = layerCount > 1;
+            if (sdkEvaluation) {
+                scene->SetCurrentAnimationStack(animStack);
+            }
+        } else {
+            cache.times.resize(1);
+        }
+        
+        size_t frameCount = cache.times.size();
+        size_t boneCount = cache.bones.size();
+        cache.globals.resize(frameCount * boneCount);
+        
+        const char* components[] = { FBXSDK_CURVENODE_COMPONENT_X, FBXSDK_CURVENODE_COMPONENT_Y, FBXSDK_CURVENODE_COMPONENT_Z };
+        std::vector<double> samples[9];
+        
+        for (size_t bone = 0; bone < boneCount; bone++) {
+            FbxNode* node = cache.bones[bone];
+            int parent = cache.parents[bone];
+            
+            if (!sdkEvaluation) {
+                FbxPropertyT<FbxDouble3>* properties[] = { &node->LclTranslation, &node->LclRotation, &node->LclScaling };
+                for (int p = 0; p < 3; p++) {
+                    FbxDouble3 staticValue = properties[p]->Get();
+                    for (int component = 0; component < 3; component++) {
+                        std::vector<double>& channel = samples[p * 3 + component];
+                        channel.assign(frameCount, staticValue[component]);
+                        
+                        FbxAnimCurve* curve = layer ? properties[p]->GetCurve(layer, components[component]) : nullptr;
+                        if (!curve || curve->KeyGetCount() == 0) continue;
+                        
+                        int lastIndex = 0;
+                        for (size_t frame = 0; frame < frameCount; frame++) {
+                            channel[frame] = curve->Evaluate(cache.times[frame], &lastIndex);
+                        }
+                    }
+                }
+            }
+            
+            for (size_t frame = 0; frame < frameCount; frame++) {
+                FbxAMatrix local;
+                if (sdkEvaluation) {
+                    local = node->EvaluateLocalTransform(cache.times[frame]);
+                } else {
+                    local = ComposeLocalTransform(node,
+                        FbxVector4(samples[0][frame], samples[1][frame], samples[2][frame]),
+                        FbxVector4(samples[3][frame], samples[4][frame], samples[5][frame]),
+                        FbxVector4(samples[6][frame], samples[7][frame], samples[8][frame]));
+                }
+                
+                FbxAMatrix& global = cache.globals[frame * boneCount + bone];
+                global = parent >= 0 ? cache.globals[frame * boneCount + parent] * local : local;
+            }
+        }
+        
+        return cache;
+    }
+    
+    // Reference child for the facing direction: the first child named like a spine, else the first child.
+    FbxNode* FindSpineNode(FbxNode* hipNode) {
+        for (int i = 0; i < hipNode->GetChildCount(); ++i) {
+            FbxNode* child = hipNode->GetChild(i);
+            if (child->GetName() && std::string(child->GetName()).find("Spine") != std::string::npos) {
+                return child;
+            }
+        }
+        return hipNode->GetChildCount() > 0 ? hipNode->GetChild(0) : nullptr;
+    }
+    
+    // Moves the actor so the mean horizontal position of its root over the whole take sits at the
+    // origin (height is kept), and optionally turns it about Y so its dominant heading faces +Z.
+    // The heading is the hip-to-spine direction projected onto the ground, summed over all frames,
+    // so brief turns don't decide it. Both come from global transform caches of every stack.
+    void CenterActor(FbxScene* scene, bool rotateToFaceZ = false) {
+        SceneIndex sceneIndex = BuildSceneIndex(scene);
+        std::vector<FbxNode*> skeletons = sceneIndex.SkeletonRoots();
+        
+        if (skeletons.empty()) {
+            LogError("No skeletons found in the scene!");
+            return;
+        }
+        
+        FbxNode* skeletonRoot = skeletons[0];
+        FbxNode* spineNode = rotateToFaceZ ? FindSpineNode(skeletonRoot) : nullptr;
+        
+        std::vector<FbxNode*> sampledNodes = { skeletonRoot };
+        if (spineNode) sampledNodes.push_back(spineNode);
+        
+        std::vector<FbxAnimStack*> animStacks;
+        for (int stackIndex = 0; stackIndex < scene->GetSrcObjectCount<FbxAnimStack>(); stackIndex++) {
+            animStacks.push_back(scene->GetSrcObject<FbxAnimStack>(stackIndex));
+        }
+        if (animStacks.empty()) {
+            animStacks.push_back(nullptr);
+        }
+        
+        double sumX = 0.0, sumZ = 0.0;
+        double headingX = 0.0, headingZ = 0.0;
+        size_t sampledFrames = 0;
+        for (FbxAnimStack* animStack : animStacks) {
+            GlobalTransformCache cache = BuildGlobalTransformCache(scene, sceneIndex, animStack, sampledNodes);
+            int rootBone = cache.BoneIndex(skeletonRoot);
+            int spineBone = spineNode ? cache.BoneIndex(spineNode) : -1;
+            
+            for (size_t frame = 0; frame < cache.FrameCount(); frame++) {
+                FbxVector4 rootPosition = cache.Global(frame, rootBone).GetT();
+                sumX += rootPosition[0];
+                sumZ += rootPosition[2];
+                
+                if (spineBone >= 0) {
+                    FbxVector4 forward = cache.Global(frame, spineBone).GetT() - rootPosition;
+                    headingX += forward[0];
+                    headingZ += forward[2];
+                }
+            }
+            sampledFrames += cache.FrameCount();
+        }
+        
+        // the root sits directly under the scene root in extracted scenes, so world and local offsets agree
+        FbxDouble3 translationOffset = FbxDouble3(
+            -sumX / sampledFrames,
+            0.0,  // keep Y unchanged
+            -sumZ / sampledFrames
+        );
+        ApplyTranslationToNodeAndAnimation(skeletonRoot, translationOffset, scene);
+        
+        if (rotateToFaceZ && std::hypot(headingX, headingZ) > 1e-9) {
+            double angle = atan2(headingX, headingZ) * 180.0 / 3.141592653589793;
+            ApplyYawToNodeAndAnimation(skeletonRoot, -angle, scene);
+        }
+    }
+    
+    // An FBX curve loaded into an AnimationChannel, kept next to its source for write-back.
+    struct BoundChannel {
+        FbxAnimCurve* curve = nullptr;
+        AnimationChannel channel;
+    };
+    
+    void LoadChannel(FbxAnimCurve* curve, AnimationChannel& channel) {
+        int keyCount = curve->KeyGetCount();
+        channel.Resize(keyCount);
+        for (int keyIndex = 0; keyIndex < keyCount; keyIndex++) {
+            channel.times[keyIndex] = curve->KeyGetTime(keyIndex).Get();
+            channel.values[keyIndex] = curve->KeyGetValue(keyIndex);
+        }
+    }
+    
+    // The SDK has no array setter for key values, so this is one KeySetValue per key, batched
+    // in a single modify block; all per-key arithmetic happens in AnimationKernels beforehand.
+    void StoreChannelValues(const AnimationChannel& channel, FbxAnimCurve* curve) {
+        curve->KeyModifyBegin();
+        for (size_t keyIndex = 0; keyIndex < channel.Size(); keyIndex++) {
+            curve->KeySetValue(static_cast<int>(keyIndex), channel.values[keyIndex]);
+        }
+        curve->KeyModifyEnd();
+    }
+    
+    // Loads one component of a property's base-layer curves, one per stack of the scene. Layers
+    // above the base one are additive and hold deltas, which offsets and pivots do not apply to.
+    std::vector<BoundChannel> LoadPropertyChannels(FbxScene* scene, FbxPropertyT<FbxDouble3>& property, const char* component) {
+        std::vector<BoundChannel> channels;
+        
+        int animStackCount = scene->GetSrcObjectCount<FbxAnimStack>();
+        for (int stackIndex = 0; stackIndex < animStackCount; stackIndex++) {
+            FbxAnimStack* animStack = scene->GetSrcObject<FbxAnimStack>(stackIndex);
+            if (animStack->GetMemberCount<FbxAnimLayer>() == 0) continue;
+            
+            FbxAnimCurve* curve = property.GetCurve(animStack->GetMember<FbxAnimLayer>(0), component);
+            if (!curve) continue;
+            
+            channels.emplace_back();
+            channels.back().curve = curve;
+            LoadChannel(curve, channels.back().channel);
+        }
+        
+        return channels;
+    }
+    
+    // Adds offset to one component of a property: to its base-layer curves, and to its static
+    // value, which is what a stack without a base-layer curve for the component evaluates to.
+    void OffsetPropertyChannels(FbxScene* scene, FbxPropertyT<FbxDouble3>& property, int componentIndex, const char* component, double offset) {
+        for (BoundChannel& bound : LoadPropertyChannels(scene, property, component)) {
+            AnimationKernels::AddScalar(bound.channel, static_cast<float>(offset));
+            StoreChannelValues(bound.channel, bound.curve);
+        }
+        
+        FbxDouble3 value = property.Get();
+        value[componentIndex] += offset;
+        property.Set(value);
+    }
+    
+    void ApplyTranslationToNodeAndAnimation(FbxNode* node, const FbxDouble3& translationOffset, FbxScene* scene) {
+        OffsetPropertyChannels(scene, node->LclTranslation, 0, FBXSDK_CURVENODE_COMPONENT_X, translationOffset[0]);
+        OffsetPropertyChannels(scene, node->LclTranslation, 2, FBXSDK_CURVENODE_COMPONENT_Z, translationOffset[2]);
+    }
+    
+    // Turns a node about the world Y axis through the origin, its parent being the scene root. The
+    // yaw goes into the pre-rotation, which the SDK applies outside the animated rotation, and the
+    // translation is rotated to match: t' = yaw * (t + c) - c, with c the rotation offset plus pivot.
+    // This is exact for every rotation order and leaves the rotation curves untouched.
+    void ApplyYawToNodeAndAnimation(FbxNode* node, double yawDegrees, FbxScene* scene) {
+        if (!node->RotationActive.Get()) {
+            // inactive means XYZ order with no pre/post rotation, which stays the case once active
+            node->PreRotation.Set(FbxDouble3(0.0, 0.0, 0.0));
+            node->PostRotation.Set(FbxDouble3(0.0, 0.0, 0.0));
+            node->SetRotationOrder(FbxNode::eSourcePivot, eEulerXYZ);
+            node->RotationActive.Set(true);
+        }
+        
+        FbxAMatrix yaw, preRotation;
+        yaw.SetR(FbxVector4(0.0, yawDegrees, 0.0));
+        preRotation.SetR(FbxVector4(node->PreRotation.Get()));
+        FbxVector4 newPreRotation = (yaw * preRotation).GetR();
+        node->PreRotation.Set(FbxDouble3(newPreRotation[0], newPreRotation[1], newPreRotation[2]));
+        
+        double radians = yawDegrees * 3.141592653589793 / 180.0;
+        float cosYaw = static_cast<float>(std::cos(radians));
+        float sinYaw = static_cast<float>(std::sin(radians));
+        FbxDouble3 rotationOffset = node->RotationOffset.Get();
+        FbxDouble3 rotationPivot = node->RotationPivot.Get();
+        
+        float centerX = static_cast<float>(rotationOffset[0] + rotationPivot[0]);
+        float centerZ = static_cast<float>(rotationOffset[2] + rotationPivot[2]);
+        
+        FbxDouble3 translation = node->LclTranslation.Get();
+        float staticX = static_cast<float>(translation[0]);
+        float staticZ = static_cast<float>(translation[2]);
+        AnimationKernels::RotateXZ(&staticX, &staticZ, 1, cosYaw, sinYaw, centerX, centerZ);
+        
+        int animStackCount = scene->GetSrcObjectCount<FbxAnimStack>();
+        for (int stackIndex = 0; stackIndex < animStackCount; stackIndex++) {
+            FbxAnimStack* animStack = scene->GetSrcObject<FbxAnimStack>(stackIndex);
+            
+            int layerCount = animStack->GetMemberCount<FbxAnimLayer>();
+            for (int layerIndex = 0; layerIndex < layerCount; layerIndex++) {
+                FbxAnimLayer* animLayer = animStack->GetMember<FbxAnimLayer>(layerIndex);
+                bool baseLayer = layerIndex == 0;
+                
+                FbxAnimCurve* curveX = node->LclTranslation.GetCurve(animLayer, FBXSDK_CURVENODE_COMPONENT_X);
+                FbxAnimCurve* curveZ = node->LclTranslation.GetCurve(animLayer, FBXSDK_CURVENODE_COMPONENT_Z);
+                if (!curveX && !curveZ) continue;
+                
+                // X and Z mix, so both need keys at the same times; a missing curve holds the static value
+                double missingValue = 0.0;
+                if (!curveX) {
+                    missingValue = baseLayer ? translation[0] : 0.0;
+                    curveX = node->LclTranslation.GetCurve(animLayer, FBXSDK_CURVENODE_COMPONENT_X, true);
+                } else if (!curveZ) {
+                    missingValue = baseLayer ? translation[2] : 0.0;
+                    curveZ = node->LclTranslation.GetCurve(animLayer, FBXSDK_CURVENODE_COMPONENT_Z, true);
+                }
+                
+                AnimationChannel channelX, channelZ;
+                LoadChannel(curveX, channelX);
+                LoadChannel(curveZ, channelZ);
+                if (channelX.times != channelZ.times) {
+                    std::vector<int64_t> times = channelX.times;
+                    times.insert(times.end(), channelZ.times.begin(), channelZ.times.end());
+                    std::sort(times.begin(), times.end());
+                    times.erase(std::unique(times.begin(), times.end()), times.end());
+                    
+                    ResampleCurve(curveX, times, channelX.Size() ? nullptr : &missingValue);
+                    ResampleCurve(curveZ, times, channelZ.Size() ? nullptr : &missingValue);
+                    LoadChannel(curveX, channelX);
+                    LoadChannel(curveZ, channelZ);
+                }
+                
+                // additive layers hold deltas, so only the base layer carries the pivot term
+                AnimationKernels::RotateXZ(channelX, channelZ, cosYaw, sinYaw,
+                                           baseLayer ? centerX : 0.0f, baseLayer ? centerZ : 0.0f);
+                StoreChannelValues(channelX, curveX);
+                StoreChannelValues(channelZ, curveZ);
+            }
+        }
+        
+        node->LclTranslation.Set(FbxDouble3(staticX, translation[1], staticZ));
+    }
+    
+    // Rewrites a curve with keys at exactly the given times, keeping its shape by evaluating it
+    // there first. A curve with no keys yet is filled with constantValue.
+    void ResampleCurve(FbxAnimCurve* curve, const std::vector<int64_t>& times, const double* constantValue) {
+        std::vector<float> values(times.size());
+        int lastIndex = 0;
+        for (size_t i = 0; i < times.size(); i++) {
+            FbxTime time;
+            time.Set(times[i]);
+            values[i] = constantValue ? static_cast<float>(*constantValue) : curve->Evaluate(time, &lastIndex);
+        }
+        
+        curve->KeyModifyBegin();
+        curve->KeyClear();
+        lastIndex = 0;
+        for (size_t i = 0; i < times.size(); i++) {
+            FbxTime time;
+            time.Set(times[i]);
+            int keyIndex = curve->KeyAdd(time, &lastIndex);
+            curve->KeySet(keyIndex, time, values[i]);
+        }
+        curve->KeyModifyEnd();
+    }
+    
+    struct ReductionStats {
+        uint64_t keysBefore = 0;
+        uint64_t keysAfter = 0;
+        double maxTranslationError = 0.0;
+        double maxRotationError = 0.0;
+    };
+    
+    // Rewrites a curve with only the keys ReduceLinear keeps, as linear keys. The result is
+    // checked by evaluating the rewritten curve at every original key time; a curve that ends
+    // up over tolerance is put back from a copy, so a reduced file never exceeds the bound.
+    // Returns the measured error (0 when the curve was left alone).
+    double ReduceCurve(FbxAnimCurve* curve, float tolerance) {
+        AnimationChannel channel;
+        LoadChannel(curve, channel);
+        if (channel.Size() < 3) return 0.0;
+        
+        std::vector<uint32_t> kept = AnimationKernels::ReduceLinear(channel.times.data(), channel.values.data(), channel.Size(), tolerance);
+        if (kept.size() == channel.Size()) return 0.0;
+        
+        FbxAnimCurve* backup = FbxAnimCurve::Create(curve->GetFbxManager(), "");
+        backup->CopyFrom(*curve);
+        
+        curve->KeyModifyBegin();
+        curve->KeyClear();
+        int lastIndex = 0;
+        for (uint32_t keyIndex : kept) {
+            FbxTime time;
+            time.Set(channel.times[keyIndex]);
+            int newIndex = curve->KeyAdd(time, &lastIndex);
+            curve->KeySet(newIndex, time, channel.values[keyIndex], FbxAnimCurveDef::eInterpolationLinear);
+        }
+        curve->KeyModifyEnd();
+        
+        double maxError = 0.0;
+        lastIndex = 0;
+        for (size_t keyIndex = 0; keyIndex < channel.Size(); keyIndex++) {
+            FbxTime time;
+            time.Set(channel.times[keyIndex]);
+            maxError = std::max(maxError, std::fabs(static_cast<double>(curve->Evaluate(time, &lastIndex)) - channel.values[keyIndex]));
+        }
+        
+        if (maxError > tolerance) {
+            curve->KeyModifyBegin();
+            curve->CopyFrom(*backup);
+            curve->KeyModifyEnd();
+            maxError = 0.0;
+        }
+        backup->Destroy();
+        
+        return maxError;
+    }
+    
+    // Reduces the local translation and rotation curves of every node in every stack and layer.
+    void ReduceActorKeys(FbxScene* scene, const ProcessingOptions& options, ReductionStats& stats) {
+        std::vector<FbxAnimLayer*> layers;
+        int animStackCount = scene->GetSrcObjectCount<FbxAnimStack>();
+        for (int stackIndex = 0; stackIndex < animStackCount; stackIndex++) {
+            FbxAnimStack* animStack = scene->GetSrcObject<FbxAnimStack>(stackIndex);
+            for (int layerIndex = 0; layerIndex < animStack->GetMemberCount<FbxAnimLayer>(); layerIndex++) {
+                layers.push_back(animStack->GetMember<FbxAnimLayer>(layerIndex));
+            }
+        }
+        
+        const char* components[] = { FBXSDK_CURVENODE_COMPONENT_X, FBXSDK_CURVENODE_COMPONENT_Y, FBXSDK_CURVENODE_COMPONENT_Z };
+        
+        for (int nodeIndex = 0; nodeIndex < scene->GetNodeCount(); nodeIndex++) {
+            FbxNode* node = scene->GetNode(nodeIndex);
+            for (FbxAnimLayer* layer : layers) {
+                for (const char* component : components) {
+                    if (FbxAnimCurve* curve = node->LclTranslation.GetCurve(layer, component)) {
+                        stats.keysBefore += curve->KeyGetCount();
+                        double error = ReduceCurve(curve, static_cast<float>(options.translationTolerance));
+                        stats.maxTranslationError = std::max(stats.maxTranslationError, error);
+                        stats.keysAfter += curve->KeyGetCount();
+                    }
+                    if (FbxAnimCurve* curve = node->LclRotation.GetCurve(layer, component)) {
+                        stats.keysBefore += curve->KeyGetCount();
+                        double error = ReduceCurve(curve, static_cast<float>(options.rotationTolerance));
+                        stats.maxRotationError = std::max(stats.maxRotationError, error);
+                        stats.keysAfter += curve->KeyGetCount();
+                    }
+                }
+            }
+        }
+    }
+    
+    // Bones are the actor's skeleton nodes in depth-first order, so parents always come first;
+    // channels are the local translation, rotation and scaling curves of every stack and layer.
+    ClipCacheWriter::Content BuildClipCacheContent(FbxScene* scene) {
+        ClipCacheWriter::Content content;
+        
+        SceneIndex sceneIndex = BuildSceneIndex(scene);
+        std::vector<FbxNode*> boneNodes;
+        std::vector<int32_t> boneIndexOfNode(sceneIndex.nodes.size(), -1);
+        for (size_t i = 0; i < sceneIndex.nodes.size(); i++) {
+            if (sceneIndex.attributeTypes[i] != FbxNodeAttribute::eSkeleton) continue;
+            
+            FbxNode* node = sceneIndex.nodes[i];
+            ClipCacheWriter::Bone bone;
+            bone.name = node->GetName();
+            for (int parent = sceneIndex.parents[i]; parent >= 0; parent = sceneIndex.parents[parent]) {
+                if (boneIndexOfNode[parent] >= 0) {
+                    bone.parentIndex = boneIndexOfNode[parent];
+                    break;
+                }
+            }
+            
+            FbxDouble3 translation = node->LclTranslation.Get();
+            FbxDouble3 rotation = node->LclRotation.Get();
+            FbxDouble3 scaling = node->LclScaling.Get();
+            // the SDK ignores pre/post rotation on nodes with rotation inactive
+            bool rotationActive = node->RotationActive.Get();
+            FbxDouble3 preRotation = rotationActive ? node->PreRotation.Get() : FbxDouble3(0.0, 0.0, 0.0);
+            FbxDouble3 postRotation = rotationActive ? node->PostRotation.Get() : FbxDouble3(0.0, 0.0, 0.0);
+            FbxDouble3 rotationOffset = node->RotationOffset.Get();
+            FbxDouble3 rotationPivot = node->RotationPivot.Get();
+            FbxDouble3 scalingOffset = node->ScalingOffset.Get();
+            FbxDouble3 scalingPivot = node->ScalingPivot.Get();
+            for (int axis = 0; axis < 3; axis++) {
+                bone.translation[axis] = static_cast<float>(translation[axis]);
+                bone.rotation[axis] = static_cast<float>(rotation[axis]);
+                bone.scaling[axis] = static_cast<float>(scaling[axis]);
+                bone.preRotation[axis] = static_cast<float>(preRotation[axis]);
+                bone.postRotation[axis] = static_cast<float>(postRotation[axis]);
+                bone.rotationOffset[axis] = static_cast<float>(rotationOffset[axis]);
+                bone.rotationPivot[axis] = static_cast<float>(rotationPivot[axis]);
+                bone.scalingOffset[axis] = static_cast<float>(scalingOffset[axis]);
+                bone.scalingPivot[axis] = static_cast<float>(scalingPivot[axis]);
+            }
+            
+            EFbxRotationOrder rotationOrder;
+            node->GetRotationOrder(FbxNode::eSourcePivot, rotationOrder);
+            bone.rotationOrder = static_cast<uint32_t>(rotationOrder);
+            
+            boneIndexOfNode[i] = static_cast<int32_t>(boneNodes.size());
+            boneNodes.push_back(node);
+            content.bones.push_back(std::move(bone));
+        }
+        
+        const char* components[] = { FBXSDK_CURVENODE_COMPONENT_X, FBXSDK_CURVENODE_COMPONENT_Y, FBXSDK_CURVENODE_COMPONENT_Z };
+        
+        int animStackCount = scene->GetSrcObjectCount<FbxAnimStack>();
+        for (int stackIndex = 0; stackIndex < animStackCount; stackIndex++) {
+            FbxAnimStack* animStack = scene->GetSrcObject<FbxAnimStack>(stackIndex);
+            
+            ClipCacheWriter::Clip clip;
+            clip.name = animStack->GetName();
+            FbxTimeSpan timeSpan = animStack->GetLocalTimeSpan();
+            clip.startTime = timeSpan.GetStart().Get();
+            clip.stopTime = timeSpan.GetStop().Get();
+            
+            int layerCount = animStack->GetMemberCount<FbxAnimLayer>();
+            for (int layerIndex = 0; layerIndex < layerCount; layerIndex++) {
+                FbxAnimLayer* animLayer = animStack->GetMember<FbxAnimLayer>(layerIndex);
+                
+                for (size_t boneIndex = 0; boneIndex < boneNodes.size(); boneIndex++) {
+                    FbxNode* node = boneNodes[boneIndex];
+                    FbxPropertyT<FbxDouble3>* properties[] = { &node->LclTranslation, &node->LclRotation, &node->LclScaling };
+                    uint16_t propertyIds[] = { ClipCacheFormat::Translation, ClipCacheFormat::Rotation, ClipCacheFormat::Scaling };
+                    
+                    for (int p = 0; p < 3; p++) {
+                        for (uint16_t component = 0; component < 3; component++) {
+                            FbxAnimCurve* curve = properties[p]->GetCurve(animLayer, components[component]);
+                            if (!curve) continue;
+                            
+                            ClipCacheWriter::Channel channel;
+                            channel.boneIndex = static_cast<uint32_t>(boneIndex);
+                            channel.property = propertyIds[p];
+                            channel.component = component;
+                            channel.layerIndex = static_cast<uint32_t>(layerIndex);
+                            LoadChannel(curve, channel.keys);
+                            clip.channels.push_back(std::move(channel));
+                        }
+                    }
+                }
+            }
+            
+            content.clips.push_back(std::move(clip));
+        }
+        
+        return content;
+    }
+    
+    // Runs after centering, so the tolerance applies to the keys that are actually written.
+    void ReduceActor(FbxScene* scene, const ProcessingOptions& options, ActorMetrics& actorMetrics) {
+        if (!options.reduceKeys) return;
+        
+        ReductionStats stats;
+        {
+            ScopedTimer timer(&actorMetrics.record, "key_reduction");
+            ReduceActorKeys(scene, options, stats);
+        }
+        
+        actorMetrics.record.AddCount("keys_before_reduction", stats.keysBefore);
+        actorMetrics.record.AddCount("keys_after_reduction", stats.keysAfter);
+        actorMetrics.record.UpdateMax("max_translation_error", stats.maxTranslationError);
+        actorMetrics.record.UpdateMax("max_rotation_error_deg", stats.maxRotationError);
+        
+        LogInfo("  Reduced keys: " + std::to_string(stats.keysBefore) + " -> " + std::to_string(stats.keysAfter) +
+                " (max error " + std::to_string(stats.maxTranslationError) + " units, " +
+                std::to_string(stats.maxRotationError) + " deg)");
+    }
+
+public:
+    FBXProcessor() {
+        fbxManager = CreateManager();
+        exportFormat = fbxManager->GetIOPluginRegistry()->GetNativeWriterFormat();
+    }
+    
+    ~FBXProcessor() {
+        std::lock_guard<std::mutex> lock(ManagerMutex());
+        for (FbxManager* manager : pipelineManagers) {
+            manager->Destroy();
+        }
+        fbxManager->Destroy();
+    }
+    
+    FBXProcessor(const FBXProcessor&) = delete;
+    FBXProcessor& operator=(const FBXProcessor&) = delete;
+    
+    // Low-memory mode turns off import categories that extraction never uses: materials,
+    // textures, embedded media, blend shapes, characters, constraints, cameras and lights.
+    void ConfigureImport(const ProcessingOptions& options) {
+        FbxIOSettings* ios = fbxManager->GetIOSettings();
+        bool importAll = !options.lowMemory;
+        
+        ios->SetBoolProp(IMP_FBX_MATERIAL, importAll);
+        ios->SetBoolProp(IMP_FBX_TEXTURE, importAll);
+        ios->SetBoolProp(IMP_FBX_EXTRACT_EMBEDDED_DATA, importAll);
+        ios->SetBoolProp(IMP_FBX_GOBO, importAll);
+        ios->SetBoolProp(IMP_FBX_SHAPE, importAll);
+        ios->SetBoolProp(IMP_FBX_CHARACTER, importAll);
+        ios->SetBoolProp(IMP_FBX_CONSTRAINT, importAll);
+#ifdef IMP_CAMERA
+        ios->SetBoolProp(IMP_CAMERA, importAll);
+#endif
+#ifdef IMP_LIGHT
+        ios->SetBoolProp(IMP_LIGHT, importAll);
+#endif
+#ifdef IMP_AUDIO
+        ios->SetBoolProp(IMP_AUDIO, importAll);
+#endif
+    }
+    
+    // Picks the writer and FBX version for later exports and sets embedding and compression.
+    // Both of the latter only affect the binary writer. Fails when no ascii writer is registered.
+    bool ConfigureExport(const ProcessingOptions& options, std::string& error) {
+        ApplyExportSettings(fbxManager->GetIOSettings(), options);
+        
+        exportVersion = options.fbxVersion;
+        writeClipCache = options.clipCache;
+        
+        FbxIOPluginRegistry* registry = fbxManager->GetIOPluginRegistry();
+        exportFormat = registry->GetNativeWriterFormat();
+        if (!options.asciiOutput) return true;
+        
+        for (int formatIndex = 0; formatIndex < registry->GetWriterFormatCount(); formatIndex++) {
+            if (!registry->WriterIsFBX(formatIndex)) continue;
+            
+            std::string description = registry->GetWriterFormatDescription(formatIndex);
+            if (description.find("ascii") != std::string::npos) {
+                exportFormat = formatIndex;
+                return true;
+            }
+        }
+        
+        error = "No FBX ascii writer is available";
+        return false;
+    }
+    
+    static void ApplyExportSettings(FbxIOSettings* ios, const ProcessingOptions& options) {
+        ios->SetBoolProp(EXP_FBX_EMBEDDED, options.embedMedia && !options.asciiOutput);
+        if (options.compressionLevel >= 0) {
+            ios->SetBoolProp(EXP_FBX_COMPRESS_ARRAYS, options.compressionLevel > 0);
+            ios->SetIntProp(EXP_FBX_COMPRESS_LEVEL, options.compressionLevel);
+        }
+    }
+    
+    // Exports scene through a new exporter that initialize(exporter) points at its destination.
+    // The exporter is created in the scene's own manager, which uses that manager's IO settings.
+    template <typename InitializeFn>
+    bool RunExporter(FbxScene* scene, InitializeFn initialize, std::string& error) {
+        FbxExporter* exporter = FbxExporter::Create(scene->GetFbxManager(), "");
+        bool initialized = initialize(exporter);
+        
+        bool written = false;
+        if (!initialized) {
+            error = std::string("Failed to initialize exporter: ") + exporter->GetStatus().GetErrorString();
+        } else if (!exportVersion.empty() && !exporter->SetFileExportVersion(exportVersion.c_str())) {
+            error = "Unsupported FBX version: " + exportVersion;
+        } else if (!exporter->Export(scene)) {
+            error = std::string("Failed to export scene: ") + exporter->GetStatus().GetErrorString();
+        } else {
+            written = true;
+        }
+        
+        exporter->Destroy();
+        return written;
+    }
+    
+    // Exports to a temporary file next to the output and renames it into place, so a crashed
+    // run never leaves a partial .fbx for the next run to pick up. The writer is always given
+    // explicitly since the temporary name has no extension to detect it from.
+    bool WriteScene(FbxScene* scene, const std::string& outputFilePath, std::string& error) {
+        std::string tempFilePath = outputFilePath + ".tmp";
+        
+        bool written = RunExporter(scene, [&](FbxExporter* exporter) {
+            return exporter->Initialize(tempFilePath.c_str(), exportFormat, exporter->GetFbxManager()->GetIOSettings());
+        }, error);
+        
+        std::error_code fileError;
+        if (written) {
+            fs::rename(tempFilePath, outputFilePath, fileError);
+            if (fileError) {
+                error = "Failed to move export into place: " + outputFilePath + " (" + fileError.message() + ")";
+                written = false;
+            }
+        }
+        if (!written) {
+            fs::remove(tempFilePath, fileError);
+        }
+        
+        return written;
+    }
+    
+    // Exports to a caller's stream, which the exporter opens with streamData and closes again.
+    bool WriteScene(FbxScene* scene, FbxStream* stream, void* streamData, std::string& error) {
+        return RunExporter(scene, [&](FbxExporter* exporter) {
+            return exporter->Initialize(stream, streamData, exportFormat, exporter->GetFbxManager()->GetIOSettings());
+        }, error);
+    }
+    
+    // Calls fn(nodeIndex) for every source node ExtractSkeleton clones for this actor: the
+    // skeleton's subtree and the subtree of each attached skinned mesh.
+    template <typename NodeFn>
+    static void ForEachActorNode(const SceneIndex& sceneIndex, FbxNode* skeletonRoot, const std::vector<FbxNode*>& skinnedMeshes,
+                                 NodeFn fn) {
+        auto VisitSubtree = [&](FbxNode* root) {
+            int rootIndex = sceneIndex.IndexOf(root);
+            if (rootIndex < 0) return;
+            for (int nodeIndex = rootIndex; nodeIndex < sceneIndex.subtreeEnd[rootIndex]; nodeIndex++) {
+                fn(nodeIndex);
+            }
+        };
+        
+        VisitSubtree(skeletonRoot);
+        for (FbxNode* meshNode : skinnedMeshes) {
+            VisitSubtree(meshNode);
+        }
+    }
+    
+    // How many actors clone each node of sceneIndex, for ReleaseSourceActor.
+    static std::vector<int> CountNodeUsers(const SceneIndex& sceneIndex, const std::vector<FbxNode*>& skeletons,
+                                           SkinnedMeshIndex& skinnedMeshes) {
+        std::vector<int> nodeUsers(sceneIndex.nodes.size(), 0);
+        for (FbxNode* skeleton : skeletons) {
+            ForEachActorNode(sceneIndex, skeleton, skinnedMeshes[skeleton], [&](int nodeIndex) { nodeUsers[nodeIndex]++; });
+        }
+        return nodeUsers;
+    }
+    
+    // Destroys the source data an extracted actor no longer needs. Every node the actor cloned has
+    // its user count (from CountNodeUsers) dropped, and nodes no remaining actor clones lose their
+    // animation curves and, for meshes, the mesh with its skin deformers. A node shared with a
+    // later actor, through its hierarchy or a skin binding, is left intact until that actor is done.
+    void ReleaseSourceActor(FbxScene* scene, const SceneIndex& sceneIndex, FbxNode* skeletonRoot,
+                            const std::vector<FbxNode*>& skinnedMeshes, std::vector<int>& nodeUsers) {
+        std::vector<FbxAnimLayer*> layers;
+        int animStackCount = scene->GetSrcObjectCount<FbxAnimStack>();
+        for (int stackIndex = 0; stackIndex < animStackCount; stackIndex++) {
+            FbxAnimStack* animStack = scene->GetSrcObject<FbxAnimStack>(stackIndex);
+            for (int layerIndex = 0; layerIndex < animStack->GetMemberCount<FbxAnimLayer>(); layerIndex++) {
+                layers.push_back(animStack->GetMember<FbxAnimLayer>(layerIndex));
+            }
+        }
+        
+        // collected first, so a node reached through two of the actor's subtrees is released once
+        std::vector<int> released;
+        ForEachActorNode(sceneIndex, skeletonRoot, skinnedMeshes, [&](int nodeIndex) {
+            if (--nodeUsers[nodeIndex] == 0) released.push_back(nodeIndex);
+        });
+        
+        for (int nodeIndex : released) {
+            FbxNode* node = sceneIndex.nodes[nodeIndex];
+            
+            for (FbxProperty property = node->GetFirstProperty(); property.IsValid();
+                 property = node->GetNextProperty(property)) {
+                if (!property.GetFlag(FbxPropertyFlags::eAnimatable)) continue;
+                
+                for (FbxAnimLayer* layer : layers) {
+                    FbxAnimCurveNode* curveNode = property.GetCurveNode(layer);
+                    if (!curveNode) continue;
+                    
+                    std::vector<FbxAnimCurve*> curves;
+                    for (unsigned int channel = 0; channel < curveNode->GetChannelsCount(); channel++) {
+                        for (int curveIndex = 0; curveIndex < curveNode->GetCurveCount(channel); curveIndex++) {
+                            curves.push_back(curveNode->GetCurve(channel, curveIndex));
+                        }
+                    }
+                    for (FbxAnimCurve* curve : curves) {
+                        curve->Destroy();
+                    }
+                    curveNode->Destroy();
+                }
+            }
+            
+            if (sceneIndex.attributeTypes[nodeIndex] != FbxNodeAttribute::eMesh) continue;
+            
+            FbxMesh* mesh = node->GetMesh();
+            if (!mesh) continue;
+            
+            std::vector<FbxObject*> deformers;
+            for (int skinIndex = 0; skinIndex < mesh->GetDeformerCount(FbxDeformer::eSkin); skinIndex++) {
+                FbxSkin* skin = FbxCast<FbxSkin>(mesh->GetDeformer(skinIndex, FbxDeformer::eSkin));
+                if (!skin) continue;
+                for (int clusterIndex = 0; clusterIndex < skin->GetClusterCount(); clusterIndex++) {
+                    deformers.push_back(skin->GetCluster(clusterIndex));
+                }
+                deformers.push_back(skin);
+            }
+            for (FbxObject* deformer : deformers) {
+                deformer->Destroy();
+            }
+            
+            node->SetNodeAttribute(nullptr);
+            mesh->Destroy();
+        }
+    }
+    
+    // Returns nullptr and fills error when the file can't be opened or read.
+    FbxScene* ImportScene(const std::string& inputFilePath, std::string& error) {
+        FbxImporter* importer = FbxImporter::Create(fbxManager, "");
+        bool initialized = importer->Initialize(inputFilePath.c_str(), -1, fbxManager->GetIOSettings());
+        return RunImporter(importer, initialized, error);
+    }
+    
+    // Same for a caller's stream, opened with streamData. Streams that report no reader ID are
+    // read with the native FBX reader, which handles both binary and ascii.
+    FbxScene* ImportScene(FbxStream* stream, void* streamData, std::string& error) {
+        int readerFormat = stream->GetReaderID();
+        if (readerFormat < 0) {
+            readerFormat = fbxManager->GetIOPluginRegistry()->GetNativeReaderFormat();
+        }
+        
+        FbxImporter* importer = FbxImporter::Create(fbxManager, "");
+        bool initialized = importer->Initialize(stream, streamData, readerFormat, fbxManager->GetIOSettings());
+        return RunImporter(importer, initialized, error);
+    }
+    
+    // Imports through an initialized importer into a new scene and destroys the importer.
+    FbxScene* RunImporter(FbxImporter* importer, bool initialized, std::string& error) {
+        if (!initialized) {
+            error = std::string("Failed to initialize importer: ") + importer->GetStatus().GetErrorString();
+            importer->Destroy();
+            return nullptr;
+        }
+        
+        FbxScene* scene = FbxScene::Create(fbxManager, "importScene");
+        
+        if (!importer->Import(scene)) {
+            error = std::string("Failed to import scene: ") + importer->GetStatus().GetErrorString();
+            importer->Destroy();
+            scene->Destroy();
+            return nullptr;
+        }
+        
+        importer->Destroy();
+        return scene;
+    }
+    
+    FileResult ProcessFile(const std::string& inputFilePath, const ProcessingOptions& options = {}) {
+        std::string outputDir = fs::path(inputFilePath).parent_path().string();
+        
+        auto ImportInput = [&](FileResult& result) {
+            FbxScene* scene = ImportScene(inputFilePath, result.error);
+            if (scene) {
+                std::error_code sizeError;
+                result.metrics.record.AddCount("input_bytes", fs::file_size(inputFilePath, sizeError));
+            }
+            return scene;
+        };
+        auto ExportOutput = [&](FbxScene* newScene, const std::string& outputFileName, FileResult& result, ActorMetrics actorMetrics) {
+            ExportActor(newScene, (fs::path(outputDir) / outputFileName).string(), result, std::move(actorMetrics));
+        };
+        return ProcessInput(inputFilePath, options, ImportInput, ExportOutput);
+    }
+    
+    // Processes an FBX file held in memory without touching the disk. inputName only names the
+    // outputs ("walk.fbx" gives "walk_Hips.fbx") and appears in logs and metrics; the exported
+    // actors (and clip caches) are returned in result.buffers. data must stay valid until this returns.
+    FileResult ProcessBuffer(const void* data, size_t size, const std::string& inputName, const ProcessingOptions& options = {}) {
+        MemoryStream input(data, size, fbxManager->GetIOPluginRegistry()->GetNativeReaderFormat());
+        
+        // only touched by the export stage while processing runs
+        std::vector<std::pair<std::string, std::unique_ptr<MemoryStream>>> outputStreams;
+        auto OpenOutput = [&](const std::string& outputFileName) -> FbxStream* {
+            outputStreams.emplace_back(outputFileName, std::make_unique<MemoryStream>(exportFormat));
+            return outputStreams.back().second.get();
+        };
+        
+        auto OutputSize = [](FbxStream* stream) -> uintmax_t {
+            return static_cast<MemoryStream*>(stream)->Size();
+        };
+        
+        auto ImportInput = [&](FileResult& result) {
+            FbxScene* scene = ImportScene(&input, nullptr, result.error);
+            if (scene) {
+                result.metrics.record.AddCount("input_bytes", size);
+            }
+            return scene;
+        };
+        auto ExportOutput = [&](FbxScene* newScene, const std::string& outputFileName, FileResult& result, ActorMetrics actorMetrics) {
+            ExportActorToStream(newScene, outputFileName, OpenOutput, OutputSize, result, std::move(actorMetrics));
+        };
+        FileResult result = ProcessInput(inputName, options, ImportInput, ExportOutput);
+        
+        // streams of failed actors may hold partial exports, so only listed outputs are returned
+        for (const std::string& outputFileName : result.outputs) {
+            for (auto& stream : outputStreams) {
+                if (stream.second && stream.first == outputFileName) {
+                    result.buffers.push_back({ outputFileName, std::move(stream.second->Buffer()) });
+                    stream.second.reset();
+                    break;
+                }
+            }
+        }
+        return result;
+    }
+    
+    // Processes an FBX file read from a caller's stream, which the importer opens with inputData.
+    // Each output goes to the stream openOutput(outputFileName) returns: "walk_Hips.fbx" for
+    // inputName "walk.fbx", and "walk_Hips.fbxclip" with options.clipCache. The streams stay
+    // owned by the caller and must live until this returns. openOutput is never called from two
+    // threads at once, though in pipelined mode it runs on the export thread; returning nullptr
+    // fails that actor. A caller's stream has no size the processor can rely on, so actors carry
+    // no output_bytes count.
+    template <typename OpenOutputFn>
+    FileResult ProcessStream(FbxStream* input, void* inputData, const std::string& inputName, OpenOutputFn openOutput,
+                             const ProcessingOptions& options = {}) {
+        auto ImportInput = [&](FileResult& result) {
+            return ImportScene(input, inputData, result.error);
+        };
+        auto OutputSize = [](FbxStream*) {
+            return UnknownOutputBytes;
+        };
+        auto ExportOutput = [&](FbxScene* newScene, const std::string& outputFileName, FileResult& result, ActorMetrics actorMetrics) {
+            ExportActorToStream(newScene, outputFileName, openOutput, OutputSize, result, std::move(actorMetrics));
+        };
+        return ProcessInput(inputName, options, ImportInput, ExportOutput);
+    }
+    
+    // Body shared by ProcessFile, ProcessBuffer and ProcessStream. importInput(result) returns the
+    // source scene (nullptr with result.error set on failure); exportOutput(scene, outputFileName,
+    // result, metrics) writes an extracted actor and destroys its scene.
+    template <typename ImportFn, typename ExportFn>
+    FileResult ProcessInput(const std::string& inputName, const ProcessingOptions& options, ImportFn importInput, ExportFn exportOutput) {
+        FileResult result;
+        result.inputFilePath = inputName;
+        result.metrics.inputFilePath = inputName;
+        MetricsRecord& fileMetrics = result.metrics.record;
+        
+        LogInfo("Processing: " + inputName);
+        
+        // with parallel workers the high-water mark is shared, so it can't be attributed to one file
+        bool peakIsPerFile = options.resetPeakRss && options.jobs <= 1 && MemoryUsage::ResetPeakRss();
+        
+        ConfigureImport(options);
+        if (!ConfigureExport(options, result.error)) {
+            LogError(result.error);
+            return result;
+        }
+        
+        FbxScene* scene = nullptr;
+        {
+            ScopedTimer timer(&fileMetrics, "import");
+            scene = importInput(result);
+        }
+        if (!scene) {
+            LogError(result.error);
+            return result;
+        }
+        
+        SceneIndex sceneIndex;
+        std::vector<FbxNode*> skeletons;
+        SkinnedMeshIndex skinnedMeshes;
+        {
+            ScopedTimer timer(&fileMetrics, "skeleton_discovery");
+            sceneIndex = BuildSceneIndex(scene);
+            skeletons = sceneIndex.SkeletonRoots();
+            skinnedMeshes = BuildSkinnedMeshIndex(sceneIndex, skeletons);
+        }
+        fileMetrics.AddCount("skeletons", skeletons.size());
+        
+        LogInfo("Found " + std::to_string(skeletons.size()) + " skeletons in the file.");
+        
+        std::string baseFileName = fs::path(inputName).stem().string();
+        auto OutputFileNameFor = [&](const std::string& actorName) {
+            return baseFileName + "_" + actorName + ".fbx";
+        };
+        
+        // pipelining keeps several extracted scenes alive, which low-memory mode exists to avoid
+        if (options.pipeline && !options.lowMemory && skeletons.size() > 1) {
+            ProcessActorsPipelined(scene, sceneIndex, skeletons, skinnedMeshes, options, OutputFileNameFor, exportOutput, result);
+        } else {
+            std::vector<int> nodeUsers;
+            if (options.lowMemory) {
+                nodeUsers = CountNodeUsers(sceneIndex, skeletons, skinnedMeshes);
+            }
+            
+            for (size_t i = 0; i < skeletons.size(); i++) {
+                FbxNode* skeleton = skeletons[i];
+                std::string actorName = GetActorNameFromNode(skeleton);
+                LogInfo("  Processing skeleton: " + actorName);
+                
+                ActorMetrics actorMetrics;
+                actorMetrics.actorName = actorName;
+                
+                FbxScene* newScene = ExtractSkeleton(scene, sceneIndex, skeleton, skinnedMeshes[skeleton], &actorMetrics.record);
+                
+                if (options.lowMemory) {
+                    if (i + 1 == skeletons.size()) {
+                        scene->Destroy();
+                        scene = nullptr;
+                    } else {
+                        ReleaseSourceActor(scene, sceneIndex, skeleton, skinnedMeshes[skeleton], nodeUsers);
+                    }
+                }
+                
+                {
+                    ScopedTimer timer(&actorMetrics.record, "centering");
+                    CenterActor(newScene, options.rotateToFaceZ);
+                }
+                ReduceActor(newScene, options, actorMetrics);
+                
+                exportOutput(newScene, OutputFileNameFor(actorName), result, std::move(actorMetrics));
+            }
+        }
+        
+        if (scene) {
+            scene->Destroy();
+        }
+        
+        result.peakRssBytes = MemoryUsage::PeakRssBytes();
+        fileMetrics.AddCount("peak_rss_bytes", result.peakRssBytes);
+        LogInfo("  Peak RSS: " + std::to_string(result.peakRssBytes / (1024 * 1024)) + " MB" +
+                (peakIsPerFile ? "" : " (whole process)"));
+        
+        result.success = result.failedActors == 0;
+        return result;
+    }
+    
+    // Exports and destroys an extracted actor scene (plus its clip cache when configured),
+    // recording the outcome and the actor's metrics in result. An actor whose clip cache fails is
+    // failed, but its .fbx is already in place and stays listed as an output.
+    void ExportActor(FbxScene* newScene, const std::string& outputFilePath, FileResult& result,
+                     ActorMetrics actorMetrics = {}) {
+        bool exported = false;
+        {
+            ScopedTimer timer(&actorMetrics.record, "export");
+            exported = WriteScene(newScene, outputFilePath, result.error);
+        }
+        
+        std::vector<std::string> writtenPaths;
+        if (exported) {
+            writtenPaths.push_back(outputFilePath);
+        }
+        
+        fs::path clipCachePath = fs::path(outputFilePath).replace_extension(".fbxclip");
+        if (exported && writeClipCache) {
+            ScopedTimer timer(&actorMetrics.record, "clip_cache");
+            uint64_t clipCacheBytes = ClipCacheWriter::Write(BuildClipCacheContent(newScene), clipCachePath, result.error);
+            actorMetrics.record.AddCount("clip_cache_bytes", clipCacheBytes);
+            exported = clipCacheBytes > 0;
+            if (exported) {
+                writtenPaths.push_back(clipCachePath.string());
+            } else {
+                result.error += " (" + outputFilePath + " was written)";
+            }
+        }
+        
+        std::error_code sizeError;
+        uintmax_t outputBytes = writtenPaths.empty() ? 0 : fs::file_size(outputFilePath, sizeError);
+        FinishActor(newScene, exported, writtenPaths, outputBytes, result, std::move(actorMetrics));
+    }
+    
+    static constexpr uintmax_t UnknownOutputBytes = std::numeric_limits<uintmax_t>::max();
+    
+    // Same as ExportActor, but writes the actor to the stream openOutput(outputFileName) returns
+    // and its clip cache to the one returned for the .fbxclip name. outputSize(stream) gives the
+    // bytes written to the .fbx stream, or UnknownOutputBytes.
+    template <typename OpenOutputFn, typename OutputSizeFn>
+    void ExportActorToStream(FbxScene* newScene, const std::string& outputFileName, OpenOutputFn& openOutput,
+                             OutputSizeFn& outputSize, FileResult& result, ActorMetrics actorMetrics) {
+        bool exported = false;
+        uintmax_t outputBytes = 0;
+        {
+            ScopedTimer timer(&actorMetrics.record, "export");
+            FbxStream* stream = openOutput(outputFileName);
+            if (!stream) {
+                result.error = "No output stream for " + outputFileName;
+            } else {
+                exported = WriteScene(newScene, stream, nullptr, result.error);
+                outputBytes = exported ? outputSize(stream) : 0;
+            }
+        }
+        
+        std::vector<std::string> outputNames;
+        if (exported) {
+            outputNames.push_back(outputFileName);
+        }
+        
+        std::string clipCacheName = fs::path(outputFileName).replace_extension(".fbxclip").string();
+        if (exported && writeClipCache) {
+            ScopedTimer timer(&actorMetrics.record, "clip_cache");
+            std::vector<unsigned char> clipCache = ClipCacheWriter::Serialize(BuildClipCacheContent(newScene));
+            
+            FbxStream* stream = openOutput(clipCacheName);
+            exported = stream && stream->Open(nullptr) &&
+                       stream->Write(clipCache.data(), clipCache.size()) == clipCache.size();
+            if (stream) {
+                exported = stream->Close() && exported;
+            }
+            if (exported) {
+                actorMetrics.record.AddCount("clip_cache_bytes", clipCache.size());
+                outputNames.push_back(clipCacheName);
+            } else {
+                result.error = "Failed to write clip cache: " + clipCacheName + " (" + outputFileName + " was written)";
+            }
+        }
+        
+        FinishActor(newScene, exported, outputNames, outputBytes, result, std::move(actorMetrics));
+    }
+    
+    // Records an actor's outcome and metrics in result and destroys its scene. writtenPaths are
+    // the outputs that are in place, starting with the .fbx; they are kept in result.outputs (by
+    // file name) even when the actor failed, so they are never mistaken for inputs later.
+    // output_bytes is left out when outputBytes is UnknownOutputBytes.
+    void FinishActor(FbxScene* newScene, bool exported, const std::vector<std::string>& writtenPaths, uintmax_t outputBytes,
+                     FileResult& result, ActorMetrics actorMetrics) {
+        for (const std::string& outputPath : writtenPaths) {
+            result.outputs.push_back(fs::path(outputPath).filename().string());
+        }
+        if (!writtenPaths.empty() && outputBytes != UnknownOutputBytes) {
+            actorMetrics.record.AddCount("output_bytes", outputBytes);
+        }
+        
+        if (exported) {
+            LogInfo("  Successfully exported: " + writtenPaths.front());
+            result.exportedActors++;
+        } else {
+            LogError(result.error);
+            result.failedActors++;
+        }
+        
+        result.metrics.record.Merge(actorMetrics.record);
+        result.metrics.actors.push_back(std::move(actorMetrics));
+        
+        newScene->Destroy();
+    }
+    
+    // Runs extraction/centering on the calling thread and export on a second thread, connected
+    // by a bounded queue. Each extracted scene is built in a free manager of pipelineManagers and
+    // the export stage returns the manager once the scene is destroyed, so at most
+    // options.maxLiveScenes extracted scenes exist at any time and no manager is shared.
+    template <typename OutputFileNameFn, typename ExportFn>
+    void ProcessActorsPipelined(FbxScene* scene, const SceneIndex& sceneIndex, const std::vector<FbxNode*>& skeletons,
+                                SkinnedMeshIndex& skinnedMeshes, const ProcessingOptions& options, OutputFileNameFn OutputFileNameFor,
+                                ExportFn& exportOutput, FileResult& result) {
+        struct ExtractedActor {
+            FbxScene* scene = nullptr;
+            std::string outputFileName;
+            ActorMetrics metrics;
+        };
+        
+        size_t managerCount = static_cast<size_t>(std::max(1, options.maxLiveScenes));
+        while (pipelineManagers.size() < managerCount) {
+            pipelineManagers.push_back(CreateManager());
+        }
+        
+        BoundedQueue<FbxManager*> freeManagers(managerCount);
+        for (size_t i = 0; i < managerCount; i++) {
+            ApplyExportSettings(pipelineManagers[i]->GetIOSettings(), options);
+            freeManagers.Push(pipelineManagers[i]);
+        }
+        BoundedQueue<ExtractedActor> queue(managerCount);
+        
+        // result is only written by the export stage until it is joined
+        std::thread exportStage([&]() {
+            ExtractedActor actor;
+            while (queue.Pop(actor)) {
+                FbxManager* manager = actor.scene->GetFbxManager();
+                try {
+                    exportOutput(actor.scene, actor.outputFileName, result, std::move(actor.metrics));
+                } catch (const std::exception& e) {
+                    // an exception must not leave the thread; the scene stays in its manager
+                    // until the processor is destroyed
+                    result.error = "Failed to export " + actor.outputFileName + ": " + e.what();
+                    LogError(result.error);
+                    result.failedActors++;
+                }
+                freeManagers.Push(manager);
+            }
+        });
+        
+        try {
+            for (FbxNode* skeleton : skeletons) {
+                std::string actorName = GetActorNameFromNode(skeleton);
+                LogInfo("  Processing skeleton: " + actorName);
+                
+                FbxManager* manager = nullptr;
+                freeManagers.Pop(manager);
+                
+                ExtractedActor actor;
+                actor.outputFileName = OutputFileNameFor(actorName);
+                actor.metrics.actorName = actorName;
+                actor.scene = ExtractSkeleton(scene, sceneIndex, skeleton, skinnedMeshes[skeleton], &actor.metrics.record, manager);
+                
+                {
+                    ScopedTimer timer(&actor.metrics.record, "centering");
+                    CenterActor(actor.scene, options.rotateToFaceZ);
+                }
+                ReduceActor(actor.scene, options, actor.metrics);
+                
+                queue.Push(std::move(actor));
+            }
+        } catch (...) {
+            // destroying a joinable thread terminates the process, so let the export stage
+            // finish the actors already queued before passing the exception on
+            queue.Close();
+            exportStage.join();
+            throw;
+        }
+        
+        queue.Close();
+        exportStage.join();
+    }
+    
+    // Calls work(processor, i) for every i in [0, count) on up to jobs threads, each with its own
+    // FBXProcessor (and so its own FbxManager). A single worker runs on this processor.
+    template <typename WorkFn>
+    void RunOnWorkers(size_t count, int jobs, WorkFn work) {
+        int workerCount = std::max(1, std::min<int>(jobs, static_cast<int>(count)));
+        
+        if (workerCount == 1) {
+            for (size_t i = 0; i < count; i++) {
+                work(*this, i);
+            }
+            return;
+        }
+        
+        std::atomic<size_t> nextIndex{0};
+        std::vector<std::thread> workers;
+        
+        for (int w = 0; w < workerCount; w++) {
+            workers.emplace_back([&]() {
+                FBXProcessor processor;
+                for (size_t i = nextIndex++; i < count; i = nextIndex++) {
+                    work(processor, i);
+                }
+            });
+        }
+        
+        for (std::thread& worker : workers) {
+            worker.join();
+        }
+    }
+    
+    // Decides whether an input needs rebuilding against its manifest entry. Returns the reason,
+    // or an empty string when it is up to date. Size and modification time are compared first;
+    // the content is only hashed when they differ, so unchanged inputs are skipped without a read.
+    std::string CheckManifest(const ManifestEntry* previous, const fs::path& inputPath, ManifestEntry& stamp,
+                              bool& hashed, bool force) {
+        if (force) return "forced";
+        if (!previous) return "new input";
+        if (previous->failed) return "previous run failed";
+        if (previous->optionsKey != stamp.optionsKey) return "options changed";
+        
+        for (const std::string& output : previous->outputs) {
+            if (!fs::exists(inputPath.parent_path() / output)) return "output missing";
+        }
+        
+        if (previous->size == stamp.size && previous->modifiedTime == stamp.modifiedTime) {
+            stamp.contentHash = previous->contentHash;
+            hashed = true;
+            return "";
+        }
+        
+        stamp.contentHash = ComputeContentHash(inputPath);
+        hashed = true;
+        return stamp.contentHash == previous->contentHash ? "" : "content changed";
+    }
+    
+    // Manifest entry for an input whose run failed. The outputs it did write, and those of earlier
+    // failed runs, stay listed so they are never picked up as inputs; the flag forces a rebuild.
+    static ManifestEntry FailedManifestEntry(ManifestEntry stamp, const ManifestEntry* previous,
+                                             const std::vector<std::string>& outputs) {
+        stamp.failed = true;
+        stamp.outputs = outputs;
+        if (previous) {
+            for (const std::string& output : previous->outputs) {
+                if (std::find(stamp.outputs.begin(), stamp.outputs.end(), output) == stamp.outputs.end()) {
+                    stamp.outputs.push_back(output);
+                }
+            }
+        }
+        return stamp;
+    }
+    
+    // Processes every .fbx in the directory. With options.jobs > 1 the files are spread over that
+    // many worker threads, each owning its own FbxManager; the largest files are scheduled first
+    // so a single huge take doesn't end up running alone at the end. Inputs recorded as unchanged
+    // in the directory manifest are skipped, and the tool's own outputs (Manifest::OutputsIn) are
+    // ignored, including those of runs from before the directory had a manifest.
+    std::vector<FileResult> ProcessDirectory(const std::string& directoryPath, const ProcessingOptions& options = {}) {
+        std::vector<FileResult> results;
+        int upToDateFiles = 0;
+        
+        try {
+            LogInfo("Processing directory: " + directoryPath);
+            
+            fs::path manifestPath = fs::path(directoryPath) / Manifest::FileName;
+            Manifest manifest;
+            manifest.Load(manifestPath);
+            std::unordered_set<std::string> previousOutputs = manifest.OutputsIn(directoryPath);
+            
+            struct PendingFile {
+                fs::path path;
+                ManifestEntry stamp;
+                bool hashed = false;
+            };
+            
+            std::vector<PendingFile> files;
+            for (const auto& entry : fs::directory_iterator(directoryPath)) {
+                if (!entry.is_regular_file() || entry.path().extension() != ".fbx") continue;
+                
+                std::string inputName = entry.path().filename().string();
+                if (previousOutputs.count(inputName)) continue;
+                
+                PendingFile file;
+                file.path = entry.path();
+                file.stamp.size = entry.file_size();
+                file.stamp.modifiedTime = Manifest::ModifiedTime(entry.path());
+                file.stamp.optionsKey = options.ManifestKey();
+                
+                const ManifestEntry* previous = manifest.Find(inputName);
+                std::string reason = CheckManifest(previous, file.path, file.stamp, file.hashed, options.force);
+                
+                if (reason.empty()) {
+                    upToDateFiles++;
+                    if (options.dryRun) {
+                        LogAlways("  Up to date: " + inputName);
+                    } else if (previous->modifiedTime != file.stamp.modifiedTime) {
+                        // touched but identical; record the new time so it isn't hashed again
+                        ManifestEntry refreshed = *previous;
+                        refreshed.modifiedTime = file.stamp.modifiedTime;
+                        manifest.Set(inputName, refreshed);
+                    }
+                    continue;
+                }
+                
+                if (options.dryRun) {
+                    LogAlways("  Would rebuild: " + inputName + " (" + reason + ")");
+                }
+                files.push_back(std::move(file));
+            }
+            
+            if (options.dryRun) {
+                LogAlways("Dry run: " + std::to_string(files.size()) + " files would be rebuilt, " +
+                        std::to_string(upToDateFiles) + " are up to date.");
+                return results;
+            }
+            
+            std::sort(files.begin(), files.end(), [](const PendingFile& a, const PendingFile& b) {
+                return a.stamp.size > b.stamp.size;
+            });
+            
+            results.resize(files.size());
+            
+            auto ProcessOne = [&](FBXProcessor& processor, size_t index) {
+                PendingFile& file = files[index];
+                std::string filePath = file.path.string();
+                try {
+                    if (!file.hashed) {
+                        file.stamp.contentHash = ComputeContentHash(file.path);
+                        file.hashed = true;
+                    }
+                    results[index] = processor.ProcessFile(filePath, options);
+                } catch (const std::exception& e) {
+                    results[index].inputFilePath = filePath;
+                    results[index].error = e.what();
+                    LogError("Error processing " + filePath + ": " + e.what());
+                }
+            };
+            
+            RunOnWorkers(files.size(), options.jobs, ProcessOne);
+            
+            for (size_t i = 0; i < files.size(); i++) {
+                std::string inputName = files[i].path.filename().string();
+                if (results[i].success) {
+                    ManifestEntry entry = files[i].stamp;
+                    entry.outputs = results[i].outputs;
+                    manifest.Set(inputName, std::move(entry));
+                } else {
+                    manifest.Set(inputName, FailedManifestEntry(files[i].stamp, manifest.Find(inputName), results[i].outputs));
+                }
+            }
+            
+            if (!manifest.Save(manifestPath)) {
+                LogError("Failed to write manifest: " + manifestPath.string());
+            }
+        } catch (const std::exception& e) {
+            LogError(std::string("Error processing directory: ") + e.what());
+        }
+        
+        PrintSummary(results, upToDateFiles);
+        return results;
+    }
+    
+    // Long-running service mode: processes .fbx files as they land in the directory until stop is
+    // set. New and changed files are picked up once they stop growing (inotify on Linux, polling
+    // elsewhere) and go through a bounded queue to options.jobs workers. Each worker keeps its
+    // FBXProcessor, and so its FbxManager and IO settings, for the whole run. Files already in the
+    // directory are checked against the manifest at startup like a normal run, and the manifest
+    // is saved after every file. Returns false if the directory can't be watched.
+    bool WatchDirectory(const std::string& directoryPath, const ProcessingOptions& options, const WatchOptions& watchOptions,
+                        const std::atomic<bool>& stop) {
+        fs::path manifestPath = fs::path(directoryPath) / Manifest::FileName;
+        fs::path statusPath = watchOptions.statusPath.empty() ? fs::path(directoryPath) / ".fbxprocessor-status.json"
+                                                              : fs::path(watchOptions.statusPath);
+        
+        DirectoryWatcher watcher(directoryPath, watchOptions.settleTime);
+        std::string error;
+        if (!watcher.Start(error)) {
+            LogError(error);
+            return false;
+        }
+        
+        Manifest manifest;
+        manifest.Load(manifestPath);
+        // guards manifest, ownOutputs and inFlight
+        std::mutex stateMutex;
+        std::unordered_set<std::string> ownOutputs = manifest.OutputsIn(directoryPath);
+        std::unordered_set<std::string> inFlight;
+        
+        int workerCount = std::max(1, options.jobs);
+        WatchStatus status(workerCount);
+        BoundedQueue<fs::path> queue(watchOptions.queueCapacity);
+        
+        // with more than one worker the peak RSS is shared and can't be attributed per file
+        ProcessingOptions fileOptions = options;
+        fileOptions.jobs = workerCount;
+        
+        auto Work = [&](FBXProcessor& processor) {
+            fs::path path;
+            while (queue.Pop(path)) {
+                status.Started();
+                std::string inputName = path.filename().string();
+                
+                ManifestEntry stamp;
+                std::error_code statError;
+                stamp.size = fs::file_size(path, statError);
+                stamp.modifiedTime = Manifest::ModifiedTime(path);
+                stamp.optionsKey = options.ManifestKey();
+                
+                ManifestEntry previous;
+                bool hasPrevious = false;
+                {
+                    std::lock_guard<std::mutex> lock(stateMutex);
+                    if (const ManifestEntry* entry = manifest.Find(inputName)) {
+                        previous = *entry;
+                        hasPrevious = true;
+                    }
+                }
+                
+                FileResult result;
+                result.inputFilePath = path.string();
+                bool hashed = false;
+                std::string reason;
+                try {
+                    reason = processor.CheckManifest(hasPrevious ? &previous : nullptr, path, stamp, hashed, options.force);
+                    if (!reason.empty()) {
+                        LogInfo("Picked up " + inputName + " (" + reason + ")");
+                        result = processor.ProcessFile(path.string(), fileOptions);
+                    }
+                } catch (const std::exception& e) {
+                    result.error = e.what();
+                    LogError("Error processing " + path.string() + ": " + e.what());
+                }
+                
+                {
+                    std::lock_guard<std::mutex> lock(stateMutex);
+                    if (reason.empty()) {
+                        // touched but identical
+                        previous.modifiedTime = stamp.modifiedTime;
+                        manifest.Set(inputName, previous);
+                    } else if (result.success) {
+                        stamp.outputs = result.outputs;
+                        ownOutputs.insert(result.outputs.begin(), result.outputs.end());
+                        manifest.Set(inputName, std::move(stamp));
+                    } else {
+                        ownOutputs.insert(result.outputs.begin(), result.outputs.end());
+                        manifest.Set(inputName, FailedManifestEntry(stamp, hasPrevious ? &previous : nullptr, result.outputs));
+                    }
+                    if (!manifest.Save(manifestPath)) {
+                        LogError("Failed to write manifest: " + manifestPath.string());
+                    }
+                    inFlight.erase(inputName);
+                }
+                
+                status.Finished(inputName, !reason.empty(), result.success, result.exportedActors, stamp.size, result.error);
+                status.WriteFile(statusPath, directoryPath, true);
+            }
+        };
+        
+        std::vector<std::thread> workers;
+        for (int w = 0; w < workerCount; w++) {
+            workers.emplace_back([&, w]() {
+                if (w == 0) {
+                    Work(*this);
+                    return;
+                }
+                FBXProcessor processor;
+                Work(processor);
+            });
+        }
+        
+        LogAlways("Watching " + directoryPath + " with " + std::to_string(workerCount) + " workers; status in " +
+                  statusPath.string());
+        
+        bool watching = true;
+        std::vector<std::string> stableFiles;
+        while (!stop) {
+            if (!watcher.Poll(watchOptions.pollInterval, stableFiles)) {
+                LogError("Stopped watching " + directoryPath + ": the directory is gone");
+                watching = false;
+                break;
+            }
+            
+            for (const std::string& name : stableFiles) {
+                bool defer = false;
+                {
+                    std::lock_guard<std::mutex> lock(stateMutex);
+                    if (ownOutputs.count(name)) continue;
+                    
+                    // an input being processed may still be writing [stem]_[actor].fbx outputs
+                    for (const std::string& active : inFlight) {
+                        std::string prefix = fs::path(active).stem().string() + "_";
+                        if (name == active || name.compare(0, prefix.size(), prefix) == 0) {
+                            defer = true;
+                            break;
+                        }
+                    }
+                    if (!defer) inFlight.insert(name);
+                }
+                
+                if (defer) {
+                    watcher.Defer(name);
+                    continue;
+                }
+                
+                // never wait for a worker here: the loop must keep draining events, writing the
+                // status and checking stop, so a file the full queue turns away is retried later
+                status.Queued();
+                if (!queue.TryPush(fs::path(directoryPath) / name)) {
+                    status.Unqueued();
+                    {
+                        std::lock_guard<std::mutex> lock(stateMutex);
+                        inFlight.erase(name);
+                    }
+                    watcher.Defer(name);
+                }
+            }
+            
+            status.WriteFile(statusPath, directoryPath, true);
+        }
+        
+        queue.Close();
+        for (std::thread& worker : workers) {
+            worker.join();
+        }
+        status.WriteFile(statusPath, directoryPath, false);
+        LogAlways("Stopped watching " + directoryPath + ".");
+        return watching;
+    }
+    
+    // Adds the animation curves (and their keys) that drive the node's animatable properties in one layer.
+    void CountNodeCurves(FbxNode* node, FbxAnimLayer* layer, uint64_t& curves, uint64_t& keys) {
+        for (FbxProperty property = node->GetFirstProperty(); property.IsValid(); property = node->GetNextProperty(property)) {
+            if (!property.GetFlag(FbxPropertyFlags::eAnimatable)) continue;
+            
+            FbxAnimCurveNode* curveNode = property.GetCurveNode(layer);
+            if (!curveNode) continue;
+            
+            for (unsigned int channel = 0; channel < curveNode->GetChannelsCount(); channel++) {
+                for (int curveIndex = 0; curveIndex < curveNode->GetCurveCount(channel); curveIndex++) {
+                    curves++;
+                    keys += curveNode->GetCurve(channel, curveIndex)->KeyGetCount();
+                }
+            }
+        }
+    }
+    
+    // Fills everything but the file-level fields of a report from an imported scene.
+    void AnalyzeScene(FbxScene* scene, SceneReport& report) {
+        FbxGlobalSettings& settings = scene->GetGlobalSettings();
+        
+        FbxSystemUnit unit = settings.GetSystemUnit();
+        report.unitName = unit.GetScaleFactorAsString().Buffer();
+        report.unitScaleCm = unit.GetScaleFactor();
+        
+        // the front axis is given as the parity of the two axes left once the up axis is chosen
+        FbxAxisSystem axisSystem = settings.GetAxisSystem();
+        int upSign = 1, frontSign = 1;
+        FbxAxisSystem::EUpVector up = axisSystem.GetUpVector(upSign);
+        FbxAxisSystem::EFrontVector front = axisSystem.GetFrontVector(frontSign);
+        const char* upNames[] = { "X", "Y", "Z" };
+        const char* evenFront[] = { "Y", "X", "X" };
+        const char* oddFront[] = { "Z", "Z", "Y" };
+        int upIndex = std::clamp(static_cast<int>(up) - 1, 0, 2);
+        report.upAxis = std::string(upSign < 0 ? "-" : "+") + upNames[upIndex];
+        report.frontAxis = std::string(frontSign < 0 ? "-" : "+") +
+                           (front == FbxAxisSystem::eParityEven ? evenFront[upIndex] : oddFront[upIndex]);
+        report.rightHanded = axisSystem.GetCoorSystem() == FbxAxisSystem::eRightHanded;
+        report.frameRate = SceneFrameRate(scene);
+        
+        SceneIndex sceneIndex = BuildSceneIndex(scene);
+        std::vector<FbxNode*> skeletons = sceneIndex.SkeletonRoots();
+        SkinnedMeshIndex skinnedMeshes = BuildSkinnedMeshIndex(sceneIndex, skeletons);
+        
+        report.nodes = static_cast<int>(sceneIndex.nodes.size()) - 1;
+        report.meshes = static_cast<int>(std::count(sceneIndex.attributeTypes.begin(), sceneIndex.attributeTypes.end(),
+                                                    FbxNodeAttribute::eMesh));
+        
+        std::vector<FbxAnimLayer*> layers;
+        int animStackCount = scene->GetSrcObjectCount<FbxAnimStack>();
+        for (int stackIndex = 0; stackIndex < animStackCount; stackIndex++) {
+            FbxAnimStack* animStack = scene->GetSrcObject<FbxAnimStack>(stackIndex);
+            FbxTimeSpan timeSpan = animStack->GetLocalTimeSpan();
+            
+            StackReport stack;
+            stack.name = animStack->GetName();
+            stack.startSeconds = timeSpan.GetStart().GetSecondDouble();
+            stack.stopSeconds = timeSpan.GetStop().GetSecondDouble();
+            stack.frames = static_cast<uint64_t>(std::max(0.0, stack.DurationSeconds()) * report.frameRate + 0.5) + 1;
+            
+            for (int layerIndex = 0; layerIndex < animStack->GetMemberCount<FbxAnimLayer>(); layerIndex++) {
+                FbxAnimLayer* layer = animStack->GetMember<FbxAnimLayer>(layerIndex);
+                stack.layers.push_back(layer->GetName());
+                layers.push_back(layer);
+                
+                for (size_t i = 1; i < sceneIndex.nodes.size(); i++) {
+                    CountNodeCurves(sceneIndex.nodes[i], layer, stack.curves, stack.keys);
+                }
+            }
+            report.stacks.push_back(std::move(stack));
+        }
+        
+        for (FbxNode* skeleton : skeletons) {
+            ActorReport actor;
+            actor.name = GetActorNameFromNode(skeleton);
+            actor.meshes = static_cast<int>(skinnedMeshes[skeleton].size());
+            
+            int rootIndex = sceneIndex.IndexOf(skeleton);
+            for (int i = rootIndex; i < sceneIndex.subtreeEnd[rootIndex]; i++) {
+                if (sceneIndex.attributeTypes[i] == FbxNodeAttribute::eSkeleton) actor.bones++;
+                for (FbxAnimLayer* layer : layers) {
+                    CountNodeCurves(sceneIndex.nodes[i], layer, actor.curves, actor.keys);
+                }
+            }
+            report.actors.push_back(std::move(actor));
+        }
+    }
+    
+    // Imports a file once and describes it without extracting or exporting anything. Only the
+    // categories low-memory mode keeps are imported, since nothing else is reported.
+    SceneReport AnalyzeFile(const std::string& inputFilePath) {
+        SceneReport report;
+        report.inputFilePath = inputFilePath;
+        
+        LogInfo("Analyzing: " + inputFilePath);
+        
+        ProcessingOptions importOptions;
+        importOptions.lowMemory = true;
+        ConfigureImport(importOptions);
+        
+        MetricsRecord timings;
+        FbxScene* scene = nullptr;
+        {
+            ScopedTimer timer(&timings, "import");
+            scene = ImportScene(inputFilePath, report.error);
+        }
+        if (!scene) {
+            LogError(report.error);
+            return report;
+        }
+        
+        {
+            ScopedTimer timer(&timings, "analyze");
+            AnalyzeScene(scene, report);
+            scene->Destroy();
+        }
+        report.importMs = timings.Timings()[0].second;
+        report.analyzeMs = timings.Timings()[1].second;
+        
+        std::error_code sizeError;
+        report.fileBytes = fs::file_size(inputFilePath, sizeError);
+        report.success = true;
+        return report;
+    }
+    
+    // Analyzes every .fbx in the directory on options.jobs workers, largest first, and writes
+    // [name].json per input plus rollup.json into reportDirectory. Outputs the manifest lists are
+    // skipped, as in ProcessDirectory. Returns the reports in directory order.
+    std::vector<SceneReport> AnalyzeDirectory(const std::string& directoryPath, const std::string& reportDirectory,
+                                              const ProcessingOptions& options = {}) {
+        std::vector<SceneReport> reports;
+        auto start = std::chrono::steady_clock::now();
+        
+        try {
+            LogInfo("Analyzing directory: " + directoryPath);
+            
+            Manifest manifest;
+            manifest.Load(fs::path(directoryPath) / Manifest::FileName);
+            std::unordered_set<std::string> previousOutputs = manifest.OutputsIn(directoryPath);
+            
+            std::vector<fs::path> files;
+            for (const auto& entry : fs::directory_iterator(directoryPath)) {
+                if (!entry.is_regular_file() || entry.path().extension() != ".fbx") continue;
+                if (previousOutputs.count(entry.path().filename().string())) continue;
+                files.push_back(entry.path());
+            }
+            std::sort(files.begin(), files.end());
+            
+            std::vector<size_t> order(files.size());
+            std::vector<std::uintmax_t> sizes(files.size());
+            for (size_t i = 0; i < files.size(); i++) {
+                std::error_code sizeError;
+                sizes[i] = fs::file_size(files[i], sizeError);
+                order[i] = i;
+            }
+            std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) { return sizes[a] > sizes[b]; });
+            
+            fs::create_directories(reportDirectory);
+            reports.resize(files.size());
+            
+            RunOnWorkers(order.size(), options.jobs, [&](FBXProcessor& processor, size_t i) {
+                size_t index = order[i];
+                std::string filePath = files[index].string();
+                try {
+                    reports[index] = processor.AnalyzeFile(filePath);
+                } catch (const std::exception& e) {
+                    reports[index].inputFilePath = filePath;
+                    reports[index].error = e.what();
+                    LogError("Error analyzing " + filePath + ": " + e.what());
+                }
+                
+                fs::path reportPath = fs::path(reportDirectory) / (files[index].stem().string() + ".json");
+                std::ofstream output(reportPath);
+                ReportWriter::WriteSceneJson(output, reports[index]);
+                if (!output) {
+                    LogError("Failed to write report: " + reportPath.string());
+                }
+            });
+            
+            double wallMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+            fs::path rollupPath = fs::path(reportDirectory) / "rollup.json";
+            std::ofstream output(rollupPath);
+            ReportWriter::WriteRollupJson(output, directoryPath, reports, wallMs);
+            if (!output) {
+                LogError("Failed to write report: " + rollupPath.string());
+            }
+        } catch (const std::exception& e) {
+            LogError(std::string("Error analyzing directory: ") + e.what());
+        }
+        
+        int succeeded = static_cast<int>(std::count_if(reports.begin(), reports.end(), [](const SceneReport& r) { return r.success; }));
+        LogAlways("Analysis: " + std::to_string(succeeded) + "/" + std::to_string(reports.size()) +
+                " files analyzed, reports in " + reportDirectory + ".");
+        for (const SceneReport& report : reports) {
+            if (!report.success) {
+                LogError("  FAILED: " + report.inputFilePath + " (" + report.error + ")");
+            }
+        }
+        return reports;
+    }
+    
+    static void PrintSummary(const std::vector<FileResult>& results, int upToDateFiles = 0) {
+        int succeeded = 0;
+        int exportedActors = 0;
+        std::uintmax_t peakRssBytes = 0;
+        for (const FileResult& result : results) {
+            if (result.success) succeeded++;
+            exportedActors += result.exportedActors;
+            peakRssBytes = std::max(peakRssBytes, result.peakRssBytes);
+        }
+        
+        LogAlways("Summary: " + std::to_string(succeeded) + "/" + std::to_string(results.size()) +
+                " files processed, " + std::to_string(exportedActors) + " actors exported, " +
+                std::to_string(upToDateFiles) + " files up to date, peak RSS " +
+                std::to_string(peakRssBytes / (1024 * 1024)) + " MB.");
+        
+        for (const FileResult& result : results) {
+            if (!result.success) {
+                LogError("  FAILED: " + result.inputFilePath + " (" + result.error + ")");
+            }
+        }
+    }
+};
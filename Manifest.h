@@ -0,0 +1,193 @@
+#pragma once
+
+// Per-directory record of what a previous run produced, so unchanged inputs can be
+// skipped and the tool's own outputs are never picked up as new inputs.
+//
+// The file is plain text, one tab-separated line per input:
+//   <input name> <size> <mtime> <content hash> <options key> <ok|failed> <output name>...
+// Manifests written before the status column existed are read as all "ok".
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+struct ManifestEntry {
+    std::uintmax_t size = 0;
+    int64_t modifiedTime = 0;
+    uint64_t contentHash = 0;
+    std::string optionsKey;
+    // the last run failed for some actors; the outputs it did write are still listed
+    bool failed = false;
+    std::vector<std::string> outputs;
+};
+
+// 64-bit multiply/rotate hash over 8-byte words, read in 1 MiB chunks.
+inline uint64_t ComputeContentHash(const std::filesystem::path& path) {
+    const uint64_t prime1 = 0x9E3779B185EBCA87ull;
+    const uint64_t prime2 = 0xC2B2AE3D27D4EB4Full;
+    auto Rotl = [](uint64_t x, int r) { return (x << r) | (x >> (64 - r)); };
+
+    std::ifstream file(path, std::ios::binary);
+    std::vector<char> buffer(1 << 20);
+    uint64_t lanes[4] = { prime1 + prime2, prime2, 0, 0 - prime1 };
+    uint64_t totalBytes = 0;
+    uint64_t tail = 0;
+    int tailBytes = 0;
+
+    while (file) {
+        file.read(buffer.data(), buffer.size());
+        std::streamsize bytesRead = file.gcount();
+        if (bytesRead <= 0) break;
+
+        size_t offset = 0;
+        size_t wordCount = static_cast<size_t>(bytesRead) / 8;
+        for (size_t w = 0; w < wordCount; w++, offset += 8) {
+            uint64_t word;
+            std::memcpy(&word, buffer.data() + offset, 8);
+            uint64_t& lane = lanes[(totalBytes / 8 + w) & 3];
+            lane = Rotl(lane + word * prime2, 31) * prime1;
+        }
+        totalBytes += wordCount * 8;
+
+        // only the final chunk can have a partial word, since chunks are a multiple of 8
+        for (; offset < static_cast<size_t>(bytesRead); offset++, tailBytes++) {
+            tail |= static_cast<uint64_t>(static_cast<unsigned char>(buffer[offset])) << (8 * tailBytes);
+        }
+    }
+
+    uint64_t hash = Rotl(lanes[0], 1) + Rotl(lanes[1], 7) + Rotl(lanes[2], 12) + Rotl(lanes[3], 18);
+    hash ^= Rotl(tail * prime2, 31) * prime1;
+    hash += totalBytes + tailBytes;
+    hash ^= hash >> 33;
+    hash *= prime2;
+    hash ^= hash >> 29;
+    return hash;
+}
+
+class Manifest {
+private:
+    std::unordered_map<std::string, ManifestEntry> entries;
+
+public:
+    static constexpr const char* FileName = ".fbxprocessor-manifest";
+
+    static int64_t ModifiedTime(const std::filesystem::path& path) {
+        return static_cast<int64_t>(std::filesystem::last_write_time(path).time_since_epoch().count());
+    }
+
+    bool Load(const std::filesystem::path& manifestPath) {
+        std::ifstream file(manifestPath);
+        if (!file) return false;
+
+        std::string line;
+        while (std::getline(file, line)) {
+            std::vector<std::string> fields;
+            std::stringstream stream(line);
+            std::string field;
+            while (std::getline(stream, field, '\t')) {
+                fields.push_back(field);
+            }
+            if (fields.size() < 5) continue;
+
+            // a damaged line only costs a rebuild of that input
+            ManifestEntry entry;
+            try {
+                entry.size = std::stoull(fields[1]);
+                entry.modifiedTime = std::stoll(fields[2]);
+                entry.contentHash = std::stoull(fields[3], nullptr, 16);
+            } catch (const std::exception&) {
+                continue;
+            }
+            entry.optionsKey = fields[4];
+            size_t firstOutput = 5;
+            if (fields.size() > 5 && (fields[5] == "ok" || fields[5] == "failed")) {
+                entry.failed = fields[5] == "failed";
+                firstOutput = 6;
+            }
+            entry.outputs.assign(fields.begin() + firstOutput, fields.end());
+            entries[fields[0]] = std::move(entry);
+        }
+        return true;
+    }
+
+    // Written to a temporary file and renamed so an interrupted run never leaves a torn manifest.
+    bool Save(const std::filesystem::path& manifestPath) const {
+        std::filesystem::path tempPath = manifestPath;
+        tempPath += ".tmp";
+        {
+            std::ofstream file(tempPath, std::ios::trunc);
+            if (!file) return false;
+
+            for (const auto& item : entries) {
+                const ManifestEntry& entry = item.second;
+                char hash[17];
+                std::snprintf(hash, sizeof(hash), "%016llx", static_cast<unsigned long long>(entry.contentHash));
+                file << item.first << '\t' << entry.size << '\t' << entry.modifiedTime << '\t' << hash << '\t' << entry.optionsKey
+                     << '\t' << (entry.failed ? "failed" : "ok");
+                for (const std::string& output : entry.outputs) {
+                    file << '\t' << output;
+                }
+                file << '\n';
+            }
+            if (!file) return false;
+        }
+
+        std::error_code error;
+        std::filesystem::rename(tempPath, manifestPath, error);
+        return !error;
+    }
+
+    const ManifestEntry* Find(const std::string& inputName) const {
+        auto it = entries.find(inputName);
+        return it != entries.end() ? &it->second : nullptr;
+    }
+
+    void Set(const std::string& inputName, ManifestEntry entry) {
+        entries[inputName] = std::move(entry);
+    }
+
+    std::unordered_set<std::string> AllOutputs() const {
+        std::unordered_set<std::string> outputs;
+        for (const auto& item : entries) {
+            outputs.insert(item.second.outputs.begin(), item.second.outputs.end());
+        }
+        return outputs;
+    }
+
+    // Names of the .fbx files in directory that are outputs rather than inputs: those listed here,
+    // and, among files with no entry of their own, every [stem]_[actor].fbx next to a [stem].fbx.
+    // The second rule covers outputs written before the directory had a manifest.
+    std::unordered_set<std::string> OutputsIn(const std::filesystem::path& directory) const {
+        std::unordered_set<std::string> outputs = AllOutputs();
+
+        std::vector<std::string> names;
+        std::unordered_set<std::string> stems;
+        std::error_code error;
+        for (const auto& entry : std::filesystem::directory_iterator(directory, error)) {
+            if (!entry.is_regular_file(error) || entry.path().extension() != ".fbx") continue;
+            names.push_back(entry.path().filename().string());
+            stems.insert(entry.path().stem().string());
+        }
+
+        for (const std::string& name : names) {
+            if (outputs.count(name) || Find(name)) continue;
+
+            std::string stem = std::filesystem::path(name).stem().string();
+            for (size_t underscore = stem.find('_'); underscore != std::string::npos; underscore = stem.find('_', underscore + 1)) {
+                if (stems.count(stem.substr(0, underscore))) {
+                    outputs.insert(name);
+                    break;
+                }
+            }
+        }
+        return outputs;
+    }
+};
@@ -0,0 +1,134 @@
+#pragma once
+
+// FbxStream over memory, so scenes can be imported from and exported to buffers without going
+// through the file system. A stream either reads a caller's buffer, which must outlive it, or
+// writes into a buffer of its own.
+//
+// The binary writer seeks back to patch offsets it has already written, so writes overwrite
+// existing bytes at the current position and only extend the buffer past its end.
+
+#include <fbxsdk.h>
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <vector>
+
+class MemoryStream : public FbxStream {
+private:
+    const char* readData = nullptr;
+    size_t readSize = 0;
+    std::vector<char> writeBuffer;
+    bool writable = false;
+    int readerID = -1;
+    int writerID = -1;
+    EState state = eClosed;
+    // Read is const in FbxStream
+    mutable FbxInt64 position = 0;
+    int error = 0;
+
+    const char* Data() const {
+        return writable ? writeBuffer.data() : readData;
+    }
+
+public:
+    // Reads size bytes at data with the given reader (the native FBX reader handles binary and ascii).
+    MemoryStream(const void* data, size_t size, int readerID)
+        : readData(static_cast<const char*>(data)), readSize(size), readerID(readerID) {}
+
+    // Writes with the given writer into Buffer().
+    explicit MemoryStream(int writerID) : writable(true), writerID(writerID) {}
+
+    MemoryStream(const MemoryStream&) = delete;
+    MemoryStream& operator=(const MemoryStream&) = delete;
+
+    size_t Size() const {
+        return writable ? writeBuffer.size() : readSize;
+    }
+
+    std::vector<char>& Buffer() {
+        return writeBuffer;
+    }
+
+    EState GetState() override {
+        return state;
+    }
+
+    // Opening a writable stream discards what was written before.
+    bool Open(void* /*streamData*/) override {
+        if (writable) {
+            writeBuffer.clear();
+        }
+        position = 0;
+        error = 0;
+        state = eOpen;
+        return true;
+    }
+
+    bool Close() override {
+        state = eClosed;
+        return true;
+    }
+
+    bool Flush() override {
+        return true;
+    }
+
+    size_t Write(const void* data, FbxUInt64 size) override {
+        if (!writable || state != eOpen) {
+            error = 1;
+            return 0;
+        }
+
+        size_t end = static_cast<size_t>(position) + static_cast<size_t>(size);
+        if (end > writeBuffer.size()) {
+            writeBuffer.resize(end);
+        }
+        std::memcpy(writeBuffer.data() + position, data, static_cast<size_t>(size));
+        position = static_cast<FbxInt64>(end);
+        return static_cast<size_t>(size);
+    }
+
+    size_t Read(void* data, FbxUInt64 size) const override {
+        if (state != eOpen) return 0;
+
+        size_t available = Size() - static_cast<size_t>(position);
+        size_t count = std::min(available, static_cast<size_t>(size));
+        std::memcpy(data, Data() + position, count);
+        position += static_cast<FbxInt64>(count);
+        return count;
+    }
+
+    int GetReaderID() const override {
+        return readerID;
+    }
+
+    int GetWriterID() const override {
+        return writerID;
+    }
+
+    void Seek(const FbxInt64& offset, const FbxFile::ESeekPos& seekPos) override {
+        FbxInt64 origin = 0;
+        if (seekPos == FbxFile::eCurrent) {
+            origin = position;
+        } else if (seekPos == FbxFile::eEnd) {
+            origin = static_cast<FbxInt64>(Size());
+        }
+        SetPosition(origin + offset);
+    }
+
+    FbxInt64 GetPosition() const override {
+        return position;
+    }
+
+    void SetPosition(FbxInt64 newPosition) override {
+        position = std::clamp<FbxInt64>(newPosition, 0, static_cast<FbxInt64>(Size()));
+    }
+
+    int GetError() const override {
+        return error;
+    }
+
+    void ClearError() override {
+        error = 0;
+    }
+};
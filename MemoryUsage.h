@@ -0,0 +1,62 @@
+#pragma once
+
+// Peak resident set size of the current process, used to size batch jobs against a memory budget.
+//
+// Linux can reset the high-water mark between files (via /proc/self/clear_refs), so the value
+// read after a file is that file's peak. Elsewhere the peak only grows over the process lifetime.
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#include <psapi.h>
+#elif defined(__APPLE__)
+#include <sys/resource.h>
+#endif
+
+namespace MemoryUsage {
+
+// Returns true when the peak was actually reset.
+inline bool ResetPeakRss() {
+#if defined(__linux__)
+    std::ofstream clearRefs("/proc/self/clear_refs");
+    clearRefs << "5";
+    // the kernel only sees (and can reject) the write once the buffer is flushed
+    clearRefs.flush();
+    return static_cast<bool>(clearRefs);
+#else
+    return false;
+#endif
+}
+
+inline std::uintmax_t PeakRssBytes() {
+#if defined(__linux__)
+    std::ifstream status("/proc/self/status");
+    std::string line;
+    while (std::getline(status, line)) {
+        if (line.compare(0, 6, "VmHWM:") == 0) {
+            return std::stoull(line.substr(6)) * 1024;
+        }
+    }
+    return 0;
+#elif defined(__APPLE__)
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return static_cast<std::uintmax_t>(usage.ru_maxrss); // bytes on macOS
+#elif defined(_WIN32)
+    PROCESS_MEMORY_COUNTERS counters;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+        return counters.PeakWorkingSetSize;
+    }
+    return 0;
+#else
+    return 0;
+#endif
+}
+
+} // namespace MemoryUsage
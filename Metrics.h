@@ -0,0 +1,186 @@
+#pragma once
+
+// Per-stage wall times and counters collected while processing, written out as JSON or CSV
+// with --metrics. Records keep insertion order so the output lists stages in pipeline order.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+class MetricsRecord {
+private:
+    std::vector<std::pair<std::string, double>> timingsMs;
+    std::vector<std::pair<std::string, uint64_t>> counters;
+    // merged by taking the maximum, e.g. reduction error
+    std::vector<std::pair<std::string, double>> maxima;
+
+    template <typename T>
+    static void Accumulate(std::vector<std::pair<std::string, T>>& entries, const std::string& name, T value) {
+        for (auto& entry : entries) {
+            if (entry.first == name) {
+                entry.second += value;
+                return;
+            }
+        }
+        entries.emplace_back(name, value);
+    }
+
+public:
+    void AddTime(const std::string& stage, double milliseconds) { Accumulate(timingsMs, stage, milliseconds); }
+    void AddCount(const std::string& counter, uint64_t value) { Accumulate(counters, counter, value); }
+
+    void UpdateMax(const std::string& name, double value) {
+        for (auto& entry : maxima) {
+            if (entry.first == name) {
+                entry.second = std::max(entry.second, value);
+                return;
+            }
+        }
+        maxima.emplace_back(name, value);
+    }
+
+    const std::vector<std::pair<std::string, double>>& Timings() const { return timingsMs; }
+    const std::vector<std::pair<std::string, uint64_t>>& Counters() const { return counters; }
+    const std::vector<std::pair<std::string, double>>& Maxima() const { return maxima; }
+
+    void Merge(const MetricsRecord& other) {
+        for (const auto& timing : other.timingsMs) AddTime(timing.first, timing.second);
+        for (const auto& counter : other.counters) AddCount(counter.first, counter.second);
+        for (const auto& maximum : other.maxima) UpdateMax(maximum.first, maximum.second);
+    }
+};
+
+// Adds the time between construction and destruction to a stage; a null record makes it a no-op.
+class ScopedTimer {
+private:
+    MetricsRecord* record;
+    const char* stage;
+    std::chrono::steady_clock::time_point start;
+
+public:
+    ScopedTimer(MetricsRecord* record, const char* stage)
+        : record(record), stage(stage), start(std::chrono::steady_clock::now()) {}
+
+    ScopedTimer(const ScopedTimer&) = delete;
+    ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+    ~ScopedTimer() {
+        if (record) {
+            record->AddTime(stage, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+        }
+    }
+};
+
+struct ActorMetrics {
+    std::string actorName;
+    MetricsRecord record;
+};
+
+struct FileMetrics {
+    std::string inputFilePath;
+    // file-level stages plus the totals of every actor
+    MetricsRecord record;
+    std::vector<ActorMetrics> actors;
+};
+
+namespace MetricsWriter {
+
+// JSON forbids raw control characters in strings, so those without a short escape become \u00XX.
+inline std::string EscapeJson(const std::string& text) {
+    static const char hexDigits[] = "0123456789abcdef";
+    std::string escaped;
+    for (char c : text) {
+        switch (c) {
+            case '"': escaped += "\\\""; break;
+            case '\\': escaped += "\\\\"; break;
+            case '\b': escaped += "\\b"; break;
+            case '\f': escaped += "\\f"; break;
+            case '\n': escaped += "\\n"; break;
+            case '\r': escaped += "\\r"; break;
+            case '\t': escaped += "\\t"; break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20) {
+                    escaped += "\\u00";
+                    escaped += hexDigits[(c >> 4) & 0xf];
+                    escaped += hexDigits[c & 0xf];
+                } else {
+                    escaped += c;
+                }
+        }
+    }
+    return escaped;
+}
+
+inline void WriteRecordJson(std::ostream& out, const MetricsRecord& record, const std::string& indent) {
+    out << indent << "\"timings_ms\": {";
+    for (size_t i = 0; i < record.Timings().size(); i++) {
+        out << (i ? ", " : " ") << '"' << record.Timings()[i].first << "\": " << record.Timings()[i].second;
+    }
+    out << " },\n" << indent << "\"counters\": {";
+    for (size_t i = 0; i < record.Counters().size(); i++) {
+        out << (i ? ", " : " ") << '"' << record.Counters()[i].first << "\": " << record.Counters()[i].second;
+    }
+    out << " },\n" << indent << "\"maxima\": {";
+    for (size_t i = 0; i < record.Maxima().size(); i++) {
+        out << (i ? ", " : " ") << '"' << record.Maxima()[i].first << "\": " << std::setprecision(6) << record.Maxima()[i].second
+            << std::setprecision(3);
+    }
+    out << " }";
+}
+
+inline void WriteJson(std::ostream& out, const std::vector<FileMetrics>& files) {
+    out << std::fixed << std::setprecision(3);
+    out << "{\n  \"files\": [\n";
+    for (size_t f = 0; f < files.size(); f++) {
+        const FileMetrics& file = files[f];
+        out << "    {\n      \"file\": \"" << EscapeJson(file.inputFilePath) << "\",\n";
+        WriteRecordJson(out, file.record, "      ");
+        out << ",\n      \"actors\": [\n";
+        for (size_t a = 0; a < file.actors.size(); a++) {
+            out << "        {\n          \"actor\": \"" << EscapeJson(file.actors[a].actorName) << "\",\n";
+            WriteRecordJson(out, file.actors[a].record, "          ");
+            out << "\n        }" << (a + 1 < file.actors.size() ? "," : "") << "\n";
+        }
+        out << "      ]\n    }" << (f + 1 < files.size() ? "," : "") << "\n";
+    }
+    out << "  ]\n}\n";
+}
+
+// One row per value: file,actor,kind,name,value. File-level rows leave actor empty.
+inline void WriteCsv(std::ostream& out, const std::vector<FileMetrics>& files) {
+    auto Quote = [](const std::string& text) {
+        std::string quoted = "\"";
+        for (char c : text) {
+            quoted += c;
+            if (c == '"') quoted += '"';
+        }
+        return quoted + "\"";
+    };
+    auto WriteRows = [&](const std::string& file, const std::string& actor, const MetricsRecord& record) {
+        for (const auto& timing : record.Timings()) {
+            out << Quote(file) << ',' << Quote(actor) << ",time_ms," << timing.first << ',' << timing.second << '\n';
+        }
+        for (const auto& counter : record.Counters()) {
+            out << Quote(file) << ',' << Quote(actor) << ",count," << counter.first << ',' << counter.second << '\n';
+        }
+        for (const auto& maximum : record.Maxima()) {
+            out << Quote(file) << ',' << Quote(actor) << ",max," << maximum.first << ',' << maximum.second << '\n';
+        }
+    };
+
+    out << std::fixed << std::setprecision(3);
+    out << "file,actor,kind,name,value\n";
+    for (const FileMetrics& file : files) {
+        WriteRows(file.inputFilePath, "", file.record);
+        for (const ActorMetrics& actor : file.actors) {
+            WriteRows(file.inputFilePath, actor.actorName, actor.record);
+        }
+    }
+}
+
+} // namespace MetricsWriter
@@ -0,0 +1,190 @@
+#pragma once
+
+// Read-only description of one input scene, gathered by FBXProcessor::AnalyzeFile for the
+// analyze subcommand, and the JSON writers for per-file reports and the directory rollup.
+// Nothing here depends on the FBX SDK.
+
+#include "Metrics.h"
+#include <cstdint>
+#include <iomanip>
+#include <map>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+struct ActorReport {
+    std::string name;
+    // skeleton nodes in the actor's hierarchy, root included
+    int bones = 0;
+    // meshes skinned to the actor
+    int meshes = 0;
+    // animation curves and keys on the actor's nodes, over every stack and layer
+    uint64_t curves = 0;
+    uint64_t keys = 0;
+};
+
+struct StackReport {
+    std::string name;
+    std::vector<std::string> layers;
+    double startSeconds = 0.0;
+    double stopSeconds = 0.0;
+    // frames at the scene frame rate, both ends included
+    uint64_t frames = 0;
+    uint64_t curves = 0;
+    uint64_t keys = 0;
+
+    double DurationSeconds() const { return stopSeconds - startSeconds; }
+
+    // average keys per curve per second of the take; 1 / frame time for fully baked curves
+    double KeyDensity() const {
+        double duration = DurationSeconds();
+        return curves > 0 && duration > 0.0 ? keys / (curves * duration) : 0.0;
+    }
+};
+
+struct SceneReport {
+    std::string inputFilePath;
+    bool success = false;
+    std::string error;
+    uint64_t fileBytes = 0;
+    double importMs = 0.0;
+    double analyzeMs = 0.0;
+
+    // e.g. "cm"; scale is centimeters per unit
+    std::string unitName;
+    double unitScaleCm = 1.0;
+    // e.g. "+Y"
+    std::string upAxis;
+    std::string frontAxis;
+    bool rightHanded = true;
+    double frameRate = 0.0;
+
+    int nodes = 0;
+    int meshes = 0;
+    std::vector<ActorReport> actors;
+    std::vector<StackReport> stacks;
+
+    std::string AxisSystemName() const {
+        return upAxis + " up, " + frontAxis + " front, " + (rightHanded ? "right" : "left") + "-handed";
+    }
+};
+
+namespace ReportWriter {
+
+using MetricsWriter::EscapeJson;
+
+inline void WriteSceneJson(std::ostream& out, const SceneReport& report) {
+    out << std::fixed << std::setprecision(3);
+    out << "{\n  \"file\": \"" << EscapeJson(report.inputFilePath) << "\",\n";
+    out << "  \"success\": " << (report.success ? "true" : "false") << ",\n";
+    if (!report.success) {
+        out << "  \"error\": \"" << EscapeJson(report.error) << "\"\n}\n";
+        return;
+    }
+
+    out << "  \"file_bytes\": " << report.fileBytes << ",\n";
+    out << "  \"import_ms\": " << report.importMs << ",\n";
+    out << "  \"analyze_ms\": " << report.analyzeMs << ",\n";
+    out << "  \"units\": { \"name\": \"" << EscapeJson(report.unitName) << "\", \"scale_cm\": " << std::setprecision(6)
+        << report.unitScaleCm << std::setprecision(3) << " },\n";
+    out << "  \"axis_system\": { \"up\": \"" << report.upAxis << "\", \"front\": \"" << report.frontAxis
+        << "\", \"handedness\": \"" << (report.rightHanded ? "right" : "left") << "\" },\n";
+    out << "  \"frame_rate\": " << report.frameRate << ",\n";
+    out << "  \"nodes\": " << report.nodes << ",\n";
+    out << "  \"meshes\": " << report.meshes << ",\n";
+
+    out << "  \"actors\": [\n";
+    for (size_t a = 0; a < report.actors.size(); a++) {
+        const ActorReport& actor = report.actors[a];
+        out << "    { \"name\": \"" << EscapeJson(actor.name) << "\", \"bones\": " << actor.bones
+            << ", \"meshes\": " << actor.meshes << ", \"curves\": " << actor.curves << ", \"keys\": " << actor.keys
+            << " }" << (a + 1 < report.actors.size() ? "," : "") << "\n";
+    }
+    out << "  ],\n";
+
+    out << "  \"stacks\": [\n";
+    for (size_t s = 0; s < report.stacks.size(); s++) {
+        const StackReport& stack = report.stacks[s];
+        out << "    { \"name\": \"" << EscapeJson(stack.name) << "\", \"layers\": [";
+        for (size_t l = 0; l < stack.layers.size(); l++) {
+            out << (l ? ", " : "") << '"' << EscapeJson(stack.layers[l]) << '"';
+        }
+        out << "], \"start_s\": " << stack.startSeconds << ", \"stop_s\": " << stack.stopSeconds
+            << ", \"frames\": " << stack.frames << ", \"curves\": " << stack.curves << ", \"keys\": " << stack.keys
+            << ", \"keys_per_curve_per_s\": " << stack.KeyDensity() << " }" << (s + 1 < report.stacks.size() ? "," : "")
+            << "\n";
+    }
+    out << "  ]\n}\n";
+}
+
+// Totals over every report, the distinct unit / axis / frame rate setups with how many files
+// use each (mixed setups in one delivery are usually what triage is looking for), and one
+// summary line per file.
+inline void WriteRollupJson(std::ostream& out, const std::string& directoryPath, const std::vector<SceneReport>& reports,
+                            double wallMs) {
+    int succeeded = 0;
+    uint64_t fileBytes = 0, actors = 0, bones = 0, meshes = 0, stacks = 0, frames = 0, keys = 0;
+    double durationSeconds = 0.0;
+    std::map<std::string, int> units, axisSystems, frameRates;
+
+    for (const SceneReport& report : reports) {
+        if (!report.success) continue;
+        succeeded++;
+        fileBytes += report.fileBytes;
+        actors += report.actors.size();
+        meshes += report.meshes;
+        stacks += report.stacks.size();
+        for (const ActorReport& actor : report.actors) bones += actor.bones;
+        for (const StackReport& stack : report.stacks) {
+            frames += stack.frames;
+            keys += stack.keys;
+            durationSeconds += stack.DurationSeconds();
+        }
+        units[report.unitName]++;
+        axisSystems[report.AxisSystemName()]++;
+        std::ostringstream rate;
+        rate << std::fixed << std::setprecision(3) << report.frameRate;
+        frameRates[rate.str()]++;
+    }
+
+    auto WriteCounts = [&](const char* name, const std::map<std::string, int>& counts, bool last) {
+        out << "  \"" << name << "\": {";
+        size_t i = 0;
+        for (const auto& entry : counts) {
+            out << (i++ ? ", " : " ") << '"' << EscapeJson(entry.first) << "\": " << entry.second;
+        }
+        out << " }" << (last ? "" : ",") << "\n";
+    };
+
+    out << std::fixed << std::setprecision(3);
+    out << "{\n  \"directory\": \"" << EscapeJson(directoryPath) << "\",\n";
+    out << "  \"files\": " << reports.size() << ",\n";
+    out << "  \"succeeded\": " << succeeded << ",\n";
+    out << "  \"wall_ms\": " << wallMs << ",\n";
+    out << "  \"totals\": { \"file_bytes\": " << fileBytes << ", \"actors\": " << actors << ", \"bones\": " << bones
+        << ", \"meshes\": " << meshes << ", \"stacks\": " << stacks << ", \"frames\": " << frames
+        << ", \"keys\": " << keys << ", \"duration_s\": " << durationSeconds << " },\n";
+    WriteCounts("units", units, false);
+    WriteCounts("axis_systems", axisSystems, false);
+    WriteCounts("frame_rates", frameRates, false);
+
+    out << "  \"reports\": [\n";
+    for (size_t i = 0; i < reports.size(); i++) {
+        const SceneReport& report = reports[i];
+        out << "    { \"file\": \"" << EscapeJson(report.inputFilePath) << "\", \"success\": "
+            << (report.success ? "true" : "false");
+        if (report.success) {
+            uint64_t fileKeys = 0;
+            for (const StackReport& stack : report.stacks) fileKeys += stack.keys;
+            out << ", \"actors\": " << report.actors.size() << ", \"stacks\": " << report.stacks.size()
+                << ", \"keys\": " << fileKeys;
+        } else {
+            out << ", \"error\": \"" << EscapeJson(report.error) << '"';
+        }
+        out << " }" << (i + 1 < reports.size() ? "," : "") << "\n";
+    }
+    out << "  ]\n}\n";
+}
+
+} // namespace ReportWriter
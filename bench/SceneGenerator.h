@@ -0,0 +1,181 @@
+#pragma once
+
+// Builds synthetic mocap-style FBX scenes for benchmarking, so the tool can be measured
+// without client data. Every actor gets a skeleton of limb chains hanging off its hips, an
+// optional grid mesh skinned to all of its bones, and baked rotation curves on every bone
+// (plus translation on the hips) in every stack and layer.
+
+#include <fbxsdk.h>
+#include <algorithm>
+#include <cmath>
+#include <string>
+#include <vector>
+
+struct SceneGeneratorSettings {
+    int actors = 4;
+    int bonesPerActor = 60;
+    // control points of each actor's skinned grid mesh; 0 disables meshes
+    int meshVerticesPerActor = 10000;
+    int stacks = 1;
+    int layers = 1;
+    int keysPerCurve = 1200;
+    double frameRate = 120.0;
+};
+
+class SceneGenerator {
+private:
+    FbxManager* fbxManager;
+    SceneGeneratorSettings settings;
+
+    FbxNode* CreateBone(FbxScene* scene, const std::string& name, FbxSkeleton::EType type, FbxNode* parent) {
+        FbxSkeleton* skeleton = FbxSkeleton::Create(scene, name.c_str());
+        skeleton->SetSkeletonType(type);
+
+        FbxNode* node = FbxNode::Create(scene, name.c_str());
+        node->SetNodeAttribute(skeleton);
+        parent->AddChild(node);
+        return node;
+    }
+
+    // Limb chains of four bones each, all starting at the hips; the first child is the spine
+    // so CenterActor's facing estimate has something to work with.
+    std::vector<FbxNode*> CreateSkeleton(FbxScene* scene, int actorIndex) {
+        std::string prefix = "Actor" + std::to_string(actorIndex) + "_";
+        std::vector<FbxNode*> bones;
+
+        FbxNode* hips = CreateBone(scene, prefix + "Hips", FbxSkeleton::eRoot, scene->GetRootNode());
+        hips->LclTranslation.Set(FbxDouble3(actorIndex * 250.0, 100.0, actorIndex * -75.0));
+        bones.push_back(hips);
+
+        for (int i = 1; i < settings.bonesPerActor; i++) {
+            bool startsChain = (i - 1) % 4 == 0;
+            FbxNode* parent = startsChain ? hips : bones.back();
+            std::string name = prefix + (i == 1 ? std::string("Spine") : "Bone" + std::to_string(i));
+
+            FbxNode* bone = CreateBone(scene, name, FbxSkeleton::eLimbNode, parent);
+            bone->LclTranslation.Set(startsChain ? FbxDouble3(5.0 * ((i / 4) % 3 - 1), 10.0, 0.0)
+                                                 : FbxDouble3(0.0, 12.0, 0.0));
+            bones.push_back(bone);
+        }
+
+        return bones;
+    }
+
+    void CreateSkinnedMesh(FbxScene* scene, int actorIndex, const std::vector<FbxNode*>& bones) {
+        int side = std::max(2, static_cast<int>(std::sqrt(static_cast<double>(settings.meshVerticesPerActor))));
+        std::string name = "Actor" + std::to_string(actorIndex) + "_Body";
+
+        FbxMesh* mesh = FbxMesh::Create(scene, name.c_str());
+        mesh->InitControlPoints(side * side);
+        FbxVector4* controlPoints = mesh->GetControlPoints();
+        for (int row = 0; row < side; row++) {
+            for (int column = 0; column < side; column++) {
+                controlPoints[row * side + column] = FbxVector4(column * 100.0 / side, row * 180.0 / side, 0.0);
+            }
+        }
+
+        for (int row = 0; row + 1 < side; row++) {
+            for (int column = 0; column + 1 < side; column++) {
+                int corner = row * side + column;
+                mesh->BeginPolygon();
+                mesh->AddPolygon(corner);
+                mesh->AddPolygon(corner + 1);
+                mesh->AddPolygon(corner + side + 1);
+                mesh->AddPolygon(corner + side);
+                mesh->EndPolygon();
+            }
+        }
+
+        FbxNode* meshNode = FbxNode::Create(scene, name.c_str());
+        meshNode->SetNodeAttribute(mesh);
+        scene->GetRootNode()->AddChild(meshNode);
+
+        // each control point is bound fully to one bone, round-robin
+        FbxSkin* skin = FbxSkin::Create(scene, "");
+        FbxAMatrix meshBindMatrix = meshNode->EvaluateGlobalTransform();
+        for (size_t boneIndex = 0; boneIndex < bones.size(); boneIndex++) {
+            FbxCluster* cluster = FbxCluster::Create(scene, "");
+            cluster->SetLink(bones[boneIndex]);
+            cluster->SetLinkMode(FbxCluster::eTotalOne);
+            for (int point = static_cast<int>(boneIndex); point < side * side; point += static_cast<int>(bones.size())) {
+                cluster->AddControlPointIndex(point, 1.0);
+            }
+            cluster->SetTransformMatrix(meshBindMatrix);
+            cluster->SetTransformLinkMatrix(bones[boneIndex]->EvaluateGlobalTransform());
+            skin->AddCluster(cluster);
+        }
+        mesh->AddDeformer(skin);
+    }
+
+    void CreateCurve(FbxAnimCurve* curve, double phase, double amplitude, double offset) {
+        curve->KeyModifyBegin();
+        for (int key = 0; key < settings.keysPerCurve; key++) {
+            FbxTime time;
+            time.SetSecondDouble(key / settings.frameRate);
+            int keyIndex = curve->KeyAdd(time);
+            curve->KeySetValue(keyIndex, static_cast<float>(offset + amplitude * std::sin(phase + key * 0.05)));
+            curve->KeySetInterpolation(keyIndex, FbxAnimCurveDef::eInterpolationCubic);
+        }
+        curve->KeyModifyEnd();
+    }
+
+    void AnimateActor(FbxAnimLayer* layer, const std::vector<FbxNode*>& bones) {
+        const char* components[] = { FBXSDK_CURVENODE_COMPONENT_X, FBXSDK_CURVENODE_COMPONENT_Y, FBXSDK_CURVENODE_COMPONENT_Z };
+
+        FbxNode* hips = bones.front();
+        FbxDouble3 start = hips->LclTranslation.Get();
+        for (int axis = 0; axis < 3; axis++) {
+            CreateCurve(hips->LclTranslation.GetCurve(layer, components[axis], true), axis, axis == 1 ? 3.0 : 150.0, start[axis]);
+        }
+
+        for (size_t boneIndex = 0; boneIndex < bones.size(); boneIndex++) {
+            for (int axis = 0; axis < 3; axis++) {
+                CreateCurve(bones[boneIndex]->LclRotation.GetCurve(layer, components[axis], true), boneIndex + axis, 30.0, 0.0);
+            }
+        }
+    }
+
+public:
+    SceneGenerator(FbxManager* manager, const SceneGeneratorSettings& settings) : fbxManager(manager), settings(settings) {}
+
+    FbxScene* Generate() {
+        FbxScene* scene = FbxScene::Create(fbxManager, "SyntheticScene");
+
+        std::vector<std::vector<FbxNode*>> actors;
+        for (int actorIndex = 0; actorIndex < settings.actors; actorIndex++) {
+            actors.push_back(CreateSkeleton(scene, actorIndex));
+            if (settings.meshVerticesPerActor > 0) {
+                CreateSkinnedMesh(scene, actorIndex, actors.back());
+            }
+        }
+
+        FbxTime stop;
+        stop.SetSecondDouble((settings.keysPerCurve - 1) / settings.frameRate);
+        FbxTimeSpan span(FbxTime(0), stop);
+
+        for (int stackIndex = 0; stackIndex < settings.stacks; stackIndex++) {
+            std::string stackName = "Take" + std::to_string(stackIndex + 1);
+            FbxAnimStack* stack = FbxAnimStack::Create(scene, stackName.c_str());
+            stack->SetLocalTimeSpan(span);
+
+            for (int layerIndex = 0; layerIndex < settings.layers; layerIndex++) {
+                std::string layerName = layerIndex == 0 ? "BaseLayer" : "Layer" + std::to_string(layerIndex);
+                FbxAnimLayer* layer = FbxAnimLayer::Create(scene, layerName.c_str());
+                stack->AddMember(layer);
+
+                for (const std::vector<FbxNode*>& bones : actors) {
+                    AnimateActor(layer, bones);
+                }
+            }
+        }
+
+        return scene;
+    }
+
+    bool Write(FbxScene* scene, const std::string& filePath) {
+        FbxExporter* exporter = FbxExporter::Create(fbxManager, "");
+        bool written = exporter->Initialize(filePath.c_str(), -1, fbxManager->GetIOSettings()) && exporter->Export(scene);
+        exporter->Destroy();
+        return written;
+    }
+};
@@ -0,0 +1,751 @@
+#include "FBXProcessor.h"
+#include "bench/SceneGenerator.h"
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Generates a synthetic scene, then times import, skeleton discovery, extraction, centering
+// (key reduction when enabled) and export separately over several iterations. Results are written as JSON so runs of
+// different versions can be compared.
+
+struct StageTimes {
+    std::string name;
+    std::vector<double> samplesMs;
+
+    double Min() const {
+        return samplesMs.empty() ? 0.0 : *std::min_element(samplesMs.begin(), samplesMs.end());
+    }
+
+    double Mean() const {
+        double total = 0.0;
+        for (double sample : samplesMs) total += sample;
+        return samplesMs.empty() ? 0.0 : total / samplesMs.size();
+    }
+};
+
+class ScopedStageTimer {
+private:
+    double& accumulatorMs;
+    std::chrono::steady_clock::time_point start;
+
+public:
+    explicit ScopedStageTimer(double& accumulatorMs)
+        : accumulatorMs(accumulatorMs), start(std::chrono::steady_clock::now()) {}
+
+    ~ScopedStageTimer() {
+        accumulatorMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+};
+
+// Totals over all actors of one iteration, with file sizes from exporting each actor both
+// before and after reduction.
+struct ReductionSummary {
+    uint64_t keysBefore = 0;
+    uint64_t keysAfter = 0;
+    uintmax_t bytesBefore = 0;
+    uintmax_t bytesAfter = 0;
+    double maxTranslationError = 0.0;
+    double maxRotationError = 0.0;
+};
+
+// Total exported bytes of all actors for one output variant, and the time to export them.
+struct FormatResult {
+    std::string name;
+    uintmax_t bytes = 0;
+    StageTimes exportTimes;
+};
+
+// Skinned mesh lookup through the per-scene index against the per-skeleton rescan it replaced.
+struct SkinLookupResult {
+    size_t skeletons = 0;
+    // skeleton-to-mesh pairs found by the index
+    size_t meshLinks = 0;
+    // whether the rescan found the same pairs
+    bool matches = true;
+    StageTimes index;
+    StageTimes rescan;
+};
+
+// Bulk mesh and skin transfer against a per-element copy, summed over every skinned mesh.
+struct MeshTransferResult {
+    size_t meshes = 0;
+    uint64_t controlPoints = 0;
+    uint64_t polygons = 0;
+    uint64_t influences = 0;
+    StageTimes bulk;
+    StageTimes perElement;
+};
+
+class StageBenchmark {
+private:
+    FBXProcessor& processor;
+    std::vector<StageTimes> stages;
+    ReductionSummary reduction;
+    bool reductionMeasured = false;
+    // clip caches written by the last iteration
+    std::vector<std::string> clipCachePaths;
+
+    StageTimes& Stage(const std::string& name) {
+        for (StageTimes& stage : stages) {
+            if (stage.name == name) return stage;
+        }
+        stages.push_back({ name, {} });
+        return stages.back();
+    }
+
+public:
+    explicit StageBenchmark(FBXProcessor& processor) : processor(processor) {}
+
+    const std::vector<StageTimes>& Stages() const { return stages; }
+
+    FbxManager* Manager() const { return processor.fbxManager; }
+    
+    const ReductionSummary* Reduction() const { return reductionMeasured ? &reduction : nullptr; }
+    
+    const std::vector<std::string>& ClipCachePaths() const { return clipCachePaths; }
+    
+    // Exports without destroying the scene, for the unreduced size comparison.
+    uintmax_t ExportedSize(FbxScene* scene, const std::string& outputPath) {
+        std::string error;
+        if (!processor.WriteScene(scene, outputPath, error)) return 0;
+        
+        std::error_code sizeError;
+        return fs::file_size(outputPath, sizeError);
+    }
+    
+    // Extracts every actor once, then exports all of them with each output variant. Compression
+    // left at -1 keeps whatever the manager has, so the variants that set it explicitly run last.
+    bool CompareFormats(const std::string& sourcePath, const fs::path& outputDir, const ProcessingOptions& options,
+                        int iterations, std::vector<FormatResult>& formats) {
+        struct Variant {
+            std::string name;
+            ProcessingOptions options;
+        };
+        std::vector<Variant> variants(5, Variant{ "", options });
+        variants[0].name = "binary";
+        variants[1].name = "binary_embedded";
+        variants[1].options.embedMedia = true;
+        variants[2].name = "ascii";
+        variants[2].options.asciiOutput = true;
+        variants[3].name = "binary_uncompressed";
+        variants[3].options.compressionLevel = 0;
+        variants[4].name = "binary_compression_9";
+        variants[4].options.compressionLevel = 9;
+        
+        processor.ConfigureImport(options);
+        
+        std::string error;
+        FbxScene* scene = processor.ImportScene(sourcePath, error);
+        if (!scene) {
+            std::cerr << error << std::endl;
+            return false;
+        }
+        
+        SceneIndex sceneIndex = processor.BuildSceneIndex(scene);
+        std::vector<FbxNode*> skeletons = sceneIndex.SkeletonRoots();
+        SkinnedMeshIndex skinnedMeshes = processor.BuildSkinnedMeshIndex(sceneIndex, skeletons);
+        
+        std::vector<std::pair<std::string, FbxScene*>> actors;
+        for (FbxNode* skeleton : skeletons) {
+            FbxScene* actorScene = processor.ExtractSkeleton(scene, sceneIndex, skeleton, skinnedMeshes[skeleton]);
+            processor.CenterActor(actorScene, options.rotateToFaceZ);
+            if (options.reduceKeys) {
+                FBXProcessor::ReductionStats stats;
+                processor.ReduceActorKeys(actorScene, options, stats);
+            }
+            actors.emplace_back(processor.GetActorNameFromNode(skeleton), actorScene);
+        }
+        
+        bool success = true;
+        for (size_t v = 0; v < variants.size() && success; v++) {
+            const Variant& variant = variants[v];
+            if (!processor.ConfigureExport(variant.options, error)) {
+                std::cerr << error << std::endl;
+                success = false;
+                break;
+            }
+            
+            FormatResult format;
+            format.name = variant.name;
+            for (int i = 0; i < iterations && success; i++) {
+                double exportMs = 0.0;
+                format.bytes = 0;
+                for (const auto& actor : actors) {
+                    std::string outputPath = (outputDir / (actor.first + "_" + variant.name + ".fbx")).string();
+                    {
+                        ScopedStageTimer timer(exportMs);
+                        success = processor.WriteScene(actor.second, outputPath, error);
+                    }
+                    if (!success) {
+                        std::cerr << error << std::endl;
+                        break;
+                    }
+                    
+                    std::error_code sizeError;
+                    format.bytes += fs::file_size(outputPath, sizeError);
+                }
+                format.exportTimes.samplesMs.push_back(exportMs);
+            }
+            formats.push_back(std::move(format));
+        }
+        
+        for (const auto& actor : actors) {
+            actor.second->Destroy();
+        }
+        scene->Destroy();
+        return success;
+    }
+
+    // The lookup BuildSkinnedMeshIndex replaced, kept as the baseline for --compare-skin-lookup:
+    // for each skeleton, every mesh, skin and cluster of the scene is visited again, and each
+    // cluster link is walked up its parents to see whether it belongs to that skeleton.
+    static std::vector<FbxNode*> RescanSkinnedMeshes(FbxScene* scene, FbxNode* skeletonRoot) {
+        auto InHierarchy = [&](FbxNode* node) {
+            for (; node; node = node->GetParent()) {
+                if (node == skeletonRoot) return true;
+            }
+            return false;
+        };
+        
+        std::vector<FbxNode*> meshes;
+        for (int nodeIndex = 0; nodeIndex < scene->GetNodeCount(); nodeIndex++) {
+            FbxNode* node = scene->GetNode(nodeIndex);
+            FbxMesh* mesh = node->GetMesh();
+            if (!mesh || InHierarchy(node)) continue;
+            
+            bool linked = false;
+            for (int skinIndex = 0; skinIndex < mesh->GetDeformerCount(FbxDeformer::eSkin) && !linked; skinIndex++) {
+                FbxSkin* skin = FbxCast<FbxSkin>(mesh->GetDeformer(skinIndex, FbxDeformer::eSkin));
+                if (!skin) continue;
+                for (int clusterIndex = 0; clusterIndex < skin->GetClusterCount() && !linked; clusterIndex++) {
+                    linked = InHierarchy(skin->GetCluster(clusterIndex)->GetLink());
+                }
+            }
+            if (linked) meshes.push_back(node);
+        }
+        return meshes;
+    }
+    
+    // Times building the scene index plus the skinned mesh index against rescanning the scene once
+    // per skeleton, and checks that both find the same meshes.
+    bool CompareSkinLookup(const std::string& sourcePath, const ProcessingOptions& options, int iterations,
+                           SkinLookupResult& lookup) {
+        processor.ConfigureImport(options);
+        
+        std::string error;
+        FbxScene* scene = processor.ImportScene(sourcePath, error);
+        if (!scene) {
+            std::cerr << error << std::endl;
+            return false;
+        }
+        
+        std::vector<FbxNode*> skeletons = processor.BuildSceneIndex(scene).SkeletonRoots();
+        lookup.skeletons = skeletons.size();
+        
+        for (int i = 0; i < iterations; i++) {
+            double indexMs = 0.0, rescanMs = 0.0;
+            SkinnedMeshIndex skinnedMeshes;
+            {
+                ScopedStageTimer timer(indexMs);
+                SceneIndex sceneIndex = processor.BuildSceneIndex(scene);
+                skinnedMeshes = processor.BuildSkinnedMeshIndex(sceneIndex, skeletons);
+            }
+            
+            std::vector<std::vector<FbxNode*>> rescanned;
+            {
+                ScopedStageTimer timer(rescanMs);
+                for (FbxNode* skeleton : skeletons) {
+                    rescanned.push_back(RescanSkinnedMeshes(scene, skeleton));
+                }
+            }
+            lookup.index.samplesMs.push_back(indexMs);
+            lookup.rescan.samplesMs.push_back(rescanMs);
+            
+            lookup.meshLinks = 0;
+            for (size_t s = 0; s < skeletons.size(); s++) {
+                std::vector<FbxNode*> indexed = skinnedMeshes[skeletons[s]];
+                std::sort(indexed.begin(), indexed.end());
+                std::sort(rescanned[s].begin(), rescanned[s].end());
+                lookup.matches = lookup.matches && indexed == rescanned[s];
+                lookup.meshLinks += indexed.size();
+            }
+        }
+        
+        scene->Destroy();
+        return true;
+    }
+
+    // The transfer CloneMeshGeometry and CloneSkins replaced, kept as the baseline for
+    // --compare-mesh-transfer: control points one at a time, topology rebuilt polygon by polygon
+    // and skin influences added one by one. Layer elements and materials are not copied.
+    static void CopyMeshPerElement(FbxNode* sourceNode, FbxNode* destParent, FbxScene* destScene, const CloneContext& context) {
+        FbxMesh* sourceMesh = sourceNode->GetMesh();
+        FbxMesh* mesh = FbxMesh::Create(destScene, sourceMesh->GetName());
+        
+        int controlPointCount = sourceMesh->GetControlPointsCount();
+        mesh->InitControlPoints(controlPointCount);
+        for (int point = 0; point < controlPointCount; point++) {
+            mesh->SetControlPointAt(sourceMesh->GetControlPointAt(point), point);
+        }
+        for (int polygon = 0; polygon < sourceMesh->GetPolygonCount(); polygon++) {
+            mesh->BeginPolygon();
+            for (int vertex = 0; vertex < sourceMesh->GetPolygonSize(polygon); vertex++) {
+                mesh->AddPolygon(sourceMesh->GetPolygonVertex(polygon, vertex));
+            }
+            mesh->EndPolygon();
+        }
+        
+        FbxNode* node = FbxNode::Create(destScene, sourceNode->GetName());
+        node->SetNodeAttribute(mesh);
+        destParent->AddChild(node);
+        
+        for (int skinIndex = 0; skinIndex < sourceMesh->GetDeformerCount(FbxDeformer::eSkin); skinIndex++) {
+            FbxSkin* sourceSkin = FbxCast<FbxSkin>(sourceMesh->GetDeformer(skinIndex, FbxDeformer::eSkin));
+            if (!sourceSkin) continue;
+            
+            FbxSkin* skin = FbxSkin::Create(destScene, sourceSkin->GetName());
+            for (int clusterIndex = 0; clusterIndex < sourceSkin->GetClusterCount(); clusterIndex++) {
+                FbxCluster* sourceCluster = sourceSkin->GetCluster(clusterIndex);
+                auto link = context.nodes.find(sourceCluster->GetLink());
+                if (link == context.nodes.end()) continue;
+                
+                FbxCluster* cluster = FbxCluster::Create(destScene, sourceCluster->GetName());
+                cluster->SetLink(link->second);
+                cluster->SetLinkMode(sourceCluster->GetLinkMode());
+                for (int influence = 0; influence < sourceCluster->GetControlPointIndicesCount(); influence++) {
+                    cluster->AddControlPointIndex(sourceCluster->GetControlPointIndices()[influence],
+                                                  sourceCluster->GetControlPointWeights()[influence]);
+                }
+                
+                FbxAMatrix matrix;
+                cluster->SetTransformMatrix(sourceCluster->GetTransformMatrix(matrix));
+                cluster->SetTransformLinkMatrix(sourceCluster->GetTransformLinkMatrix(matrix));
+                skin->AddCluster(cluster);
+            }
+            mesh->AddDeformer(skin);
+        }
+    }
+    
+    // Times transferring every skinned mesh with its skin into a scene that already holds the
+    // cloned skeleton, once through CloneNodeHierarchy + CloneSkins and once per element.
+    bool CompareMeshTransfer(const std::string& sourcePath, const ProcessingOptions& options, int iterations,
+                             MeshTransferResult& transfer) {
+        processor.ConfigureImport(options);
+        
+        std::string error;
+        FbxScene* scene = processor.ImportScene(sourcePath, error);
+        if (!scene) {
+            std::cerr << error << std::endl;
+            return false;
+        }
+        
+        SceneIndex sceneIndex = processor.BuildSceneIndex(scene);
+        std::vector<FbxNode*> skeletons = sceneIndex.SkeletonRoots();
+        SkinnedMeshIndex skinnedMeshes = processor.BuildSkinnedMeshIndex(sceneIndex, skeletons);
+        
+        for (FbxNode* skeleton : skeletons) {
+            for (FbxNode* meshNode : skinnedMeshes[skeleton]) {
+                FbxMesh* mesh = meshNode->GetMesh();
+                transfer.meshes++;
+                transfer.controlPoints += mesh->GetControlPointsCount();
+                transfer.polygons += mesh->GetPolygonCount();
+                for (int skinIndex = 0; skinIndex < mesh->GetDeformerCount(FbxDeformer::eSkin); skinIndex++) {
+                    FbxSkin* skin = FbxCast<FbxSkin>(mesh->GetDeformer(skinIndex, FbxDeformer::eSkin));
+                    for (int clusterIndex = 0; skin && clusterIndex < skin->GetClusterCount(); clusterIndex++) {
+                        transfer.influences += skin->GetCluster(clusterIndex)->GetControlPointIndicesCount();
+                    }
+                }
+            }
+        }
+        
+        for (int i = 0; i < iterations; i++) {
+            double bulkMs = 0.0, perElementMs = 0.0;
+            for (FbxNode* skeleton : skeletons) {
+                for (FbxNode* meshNode : skinnedMeshes[skeleton]) {
+                    for (int pass = 0; pass < 2; pass++) {
+                        FbxScene* destScene = processor.CreateNewScene(Manager());
+                        CloneContext context;
+                        FbxNode* newRoot = processor.CloneNodeHierarchy(sceneIndex, skeleton, destScene->GetRootNode(), destScene, context);
+                        // only the mesh below is transferred, not meshes inside the skeleton
+                        context.meshes.clear();
+                        
+                        if (pass == 0) {
+                            ScopedStageTimer timer(bulkMs);
+                            processor.CloneNodeHierarchy(sceneIndex, meshNode, newRoot, destScene, context);
+                            processor.CloneSkins(destScene, context);
+                        } else {
+                            ScopedStageTimer timer(perElementMs);
+                            CopyMeshPerElement(meshNode, newRoot, destScene, context);
+                        }
+                        destScene->Destroy();
+                    }
+                }
+            }
+            transfer.bulk.samplesMs.push_back(bulkMs);
+            transfer.perElement.samplesMs.push_back(perElementMs);
+        }
+        
+        scene->Destroy();
+        return true;
+    }
+
+    // One full pass over the file, with each stage's time summed over all actors.
+    bool RunIteration(const std::string& sourcePath, const fs::path& outputDir, const ProcessingOptions& options) {
+        double importMs = 0, findMs = 0, indexMs = 0, extractMs = 0, centerMs = 0, reduceMs = 0, exportMs = 0;
+        // sizes are only measured once, since the extra export would skew the export timings
+        bool measureReduction = options.reduceKeys && !reductionMeasured;
+
+        // as ProcessFile does, so the export stage measures the configured writer and settings
+        processor.ConfigureImport(options);
+        std::string error;
+        if (!processor.ConfigureExport(options, error)) {
+            std::cerr << error << std::endl;
+            return false;
+        }
+
+        FbxScene* scene = nullptr;
+        {
+            ScopedStageTimer timer(importMs);
+            scene = processor.ImportScene(sourcePath, error);
+        }
+        if (!scene) {
+            std::cerr << error << std::endl;
+            return false;
+        }
+
+        // kept under its old name so results stay comparable with earlier versions
+        SceneIndex sceneIndex;
+        std::vector<FbxNode*> skeletons;
+        {
+            ScopedStageTimer timer(findMs);
+            sceneIndex = processor.BuildSceneIndex(scene);
+            skeletons = sceneIndex.SkeletonRoots();
+        }
+
+        SkinnedMeshIndex skinnedMeshes;
+        {
+            ScopedStageTimer timer(indexMs);
+            skinnedMeshes = processor.BuildSkinnedMeshIndex(sceneIndex, skeletons);
+        }
+
+        FileResult result;
+        clipCachePaths.clear();
+        for (FbxNode* skeleton : skeletons) {
+            FbxScene* actorScene = nullptr;
+            {
+                ScopedStageTimer timer(extractMs);
+                actorScene = processor.ExtractSkeleton(scene, sceneIndex, skeleton, skinnedMeshes[skeleton]);
+            }
+            {
+                ScopedStageTimer timer(centerMs);
+                processor.CenterActor(actorScene, options.rotateToFaceZ);
+            }
+            
+            std::string actorName = processor.GetActorNameFromNode(skeleton);
+            if (options.reduceKeys) {
+                if (measureReduction) {
+                    reduction.bytesBefore += ExportedSize(actorScene, (outputDir / (actorName + "_unreduced.fbx")).string());
+                }
+                
+                FBXProcessor::ReductionStats stats;
+                {
+                    ScopedStageTimer timer(reduceMs);
+                    processor.ReduceActorKeys(actorScene, options, stats);
+                }
+                
+                if (measureReduction) {
+                    reduction.keysBefore += stats.keysBefore;
+                    reduction.keysAfter += stats.keysAfter;
+                    reduction.maxTranslationError = std::max(reduction.maxTranslationError, stats.maxTranslationError);
+                    reduction.maxRotationError = std::max(reduction.maxRotationError, stats.maxRotationError);
+                }
+            }
+            
+            std::string outputPath = (outputDir / (actorName + ".fbx")).string();
+            {
+                ScopedStageTimer timer(exportMs);
+                processor.ExportActor(actorScene, outputPath, result);
+            }
+            if (measureReduction) {
+                std::error_code sizeError;
+                reduction.bytesAfter += fs::file_size(outputPath, sizeError);
+            }
+            if (options.clipCache) {
+                clipCachePaths.push_back((outputDir / (actorName + ".fbxclip")).string());
+            }
+        }
+        reductionMeasured = reductionMeasured || measureReduction;
+
+        scene->Destroy();
+
+        Stage("import").samplesMs.push_back(importMs);
+        Stage("find_skeletons").samplesMs.push_back(findMs);
+        Stage("skinned_mesh_index").samplesMs.push_back(indexMs);
+        Stage("extract_skeleton").samplesMs.push_back(extractMs);
+        Stage("center_actor").samplesMs.push_back(centerMs);
+        if (options.reduceKeys) {
+            Stage("reduce_keys").samplesMs.push_back(reduceMs);
+        }
+        Stage("export").samplesMs.push_back(exportMs);
+        return result.failedActors == 0;
+    }
+};
+
+// Throughput of the SDK-independent per-key kernel, in keys per millisecond.
+double BenchmarkAddScalarKernel() {
+    AnimationChannel channel;
+    channel.Resize(1 << 22);
+    const int repetitions = 50;
+
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < repetitions; i++) {
+        AnimationKernels::AddScalar(channel, 0.25f);
+    }
+    double elapsedMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    return elapsedMs > 0.0 ? (static_cast<double>(channel.Size()) * repetitions) / elapsedMs : 0.0;
+}
+
+// Time to map, validate and touch the last key of every channel of each clip cache, in
+// milliseconds per file (minimum over the repetitions). Fails when there is no cache to open or
+// one of them does not open, rather than reporting a time for caches that were never written.
+bool BenchmarkClipCacheOpen(const std::vector<std::string>& paths, int repetitions, double& msPerFile) {
+    if (paths.empty()) {
+        std::cerr << "No clip caches were written" << std::endl;
+        return false;
+    }
+
+    double bestMs = 0.0;
+    for (int i = 0; i < repetitions; i++) {
+        float checksum = 0.0f;
+        auto start = std::chrono::steady_clock::now();
+        for (const std::string& path : paths) {
+            ClipCacheFile clipCache;
+            std::string error;
+            if (!clipCache.Open(path, error)) {
+                std::cerr << error << std::endl;
+                return false;
+            }
+            for (uint32_t c = 0; c < clipCache.ChannelCount(); c++) {
+                const ClipCacheFormat::Channel& channel = clipCache.GetChannel(c);
+                if (channel.keyCount) checksum += clipCache.Values(channel)[channel.keyCount - 1];
+            }
+        }
+        double elapsedMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        // keeps the key reads from being optimized away
+        volatile float sink = checksum;
+        (void)sink;
+        bestMs = (i == 0) ? elapsedMs : std::min(bestMs, elapsedMs);
+    }
+    msPerFile = bestMs / paths.size();
+    return true;
+}
+
+void PrintUsage(const char* programName) {
+    std::cout << "Usage: " << programName << " [--actors N] [--bones N] [--mesh-vertices N] [--stacks N] [--layers N]"
+              << " [--keys N] [--iterations N] [--rotate] [--reduce-keys] [--translation-tolerance U] [--rotation-tolerance DEG]"
+              << " [--fbx-version V] [--ascii] [--embed-media] [--compression N] [--compare-formats] [--compare-skin-lookup] [--compare-mesh-transfer] [--clip-cache] [--output results.json] [--scene path.fbx]" << std::endl;
+    std::cout << "  --scene path.fbx: Benchmark an existing file instead of generating one" << std::endl;
+    std::cout << "  --fbx-version V, --ascii, --embed-media, --compression N: Output settings for the timed export stage" << std::endl;
+    std::cout << "  --compare-formats: Also export every actor as binary, embedded, ascii, uncompressed and level 9 compressed,"
+              << " and report the size and export time of each" << std::endl;
+    std::cout << "  --compare-skin-lookup: Also time the skinned mesh index against rescanning the scene per skeleton" << std::endl;
+    std::cout << "  --compare-mesh-transfer: Also time the bulk skinned mesh transfer against a per-element copy" << std::endl;
+    std::cout << "  --clip-cache: Also write .fbxclip caches and time opening them" << std::endl;
+    std::cout << "  --reduce-keys: Time key reduction and report key counts and file sizes before and after" << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+    SceneGeneratorSettings settings;
+    ProcessingOptions options;
+    int iterations = 3;
+    std::string outputPath = "fbx_bench.json";
+    std::string scenePath;
+    bool compareFormats = false;
+    bool compareSkinLookup = false;
+    bool compareMeshTransfer = false;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--actors" && hasValue) settings.actors = std::atoi(argv[++i]);
+        else if (arg == "--bones" && hasValue) settings.bonesPerActor = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--mesh-vertices" && hasValue) settings.meshVerticesPerActor = std::atoi(argv[++i]);
+        else if (arg == "--stacks" && hasValue) settings.stacks = std::atoi(argv[++i]);
+        else if (arg == "--layers" && hasValue) settings.layers = std::atoi(argv[++i]);
+        else if (arg == "--keys" && hasValue) settings.keysPerCurve = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--iterations" && hasValue) iterations = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--rotate") options.rotateToFaceZ = true;
+        else if (arg == "--reduce-keys") options.reduceKeys = true;
+        else if (arg == "--fbx-version" && hasValue) options.fbxVersion = argv[++i];
+        else if (arg == "--ascii") options.asciiOutput = true;
+        else if (arg == "--embed-media") options.embedMedia = true;
+        else if (arg == "--compression" && hasValue) options.compressionLevel = std::clamp(std::atoi(argv[++i]), 0, 9);
+        else if (arg == "--compare-formats") compareFormats = true;
+        else if (arg == "--compare-skin-lookup") compareSkinLookup = true;
+        else if (arg == "--compare-mesh-transfer") compareMeshTransfer = true;
+        else if (arg == "--clip-cache") options.clipCache = true;
+        else if (arg == "--translation-tolerance" && hasValue) options.translationTolerance = std::max(0.0, std::atof(argv[++i]));
+        else if (arg == "--rotation-tolerance" && hasValue) options.rotationTolerance = std::max(0.0, std::atof(argv[++i]));
+        else if (arg == "--output" && hasValue) outputPath = argv[++i];
+        else if (arg == "--scene" && hasValue) scenePath = argv[++i];
+        else {
+            PrintUsage(argv[0]);
+            return 1;
+        }
+    }
+
+    fs::path workDir = fs::temp_directory_path() / "fbx_bench";
+    fs::create_directories(workDir);
+
+    FBXProcessor processor;
+    StageBenchmark benchmark(processor);
+
+    double generateMs = 0.0;
+    bool generated = scenePath.empty();
+    if (generated) {
+        scenePath = (workDir / "synthetic.fbx").string();
+
+        ScopedStageTimer timer(generateMs);
+        SceneGenerator generator(benchmark.Manager(), settings);
+        FbxScene* scene = generator.Generate();
+        bool written = generator.Write(scene, scenePath);
+        scene->Destroy();
+        if (!written) {
+            std::cerr << "Failed to write synthetic scene: " << scenePath << std::endl;
+            return 1;
+        }
+    }
+
+    for (int i = 0; i < iterations; i++) {
+        if (!benchmark.RunIteration(scenePath, workDir, options)) {
+            return 1;
+        }
+    }
+    
+    std::vector<FormatResult> formats;
+    if (compareFormats && !benchmark.CompareFormats(scenePath, workDir, options, iterations, formats)) {
+        return 1;
+    }
+
+    SkinLookupResult skinLookup;
+    if (compareSkinLookup && !benchmark.CompareSkinLookup(scenePath, options, iterations, skinLookup)) {
+        return 1;
+    }
+
+    MeshTransferResult meshTransfer;
+    if (compareMeshTransfer && !benchmark.CompareMeshTransfer(scenePath, options, iterations, meshTransfer)) {
+        return 1;
+    }
+
+    double clipCacheOpenMs = 0.0;
+    if (options.clipCache && !BenchmarkClipCacheOpen(benchmark.ClipCachePaths(), iterations, clipCacheOpenMs)) {
+        return 1;
+    }
+
+    std::ostringstream json;
+    json << std::fixed << std::setprecision(3);
+    json << "{\n";
+    json << "  \"version\": 1,\n";
+    json << "  \"scene\": {\n";
+    json << "    \"path\": \"" << MetricsWriter::EscapeJson(fs::path(scenePath).generic_string()) << "\",\n";
+    json << "    \"bytes\": " << fs::file_size(scenePath) << ",\n";
+    json << "    \"generated\": " << (generated ? "true" : "false") << ",\n";
+    json << "    \"actors\": " << settings.actors << ",\n";
+    json << "    \"bones_per_actor\": " << settings.bonesPerActor << ",\n";
+    json << "    \"mesh_vertices_per_actor\": " << settings.meshVerticesPerActor << ",\n";
+    json << "    \"stacks\": " << settings.stacks << ",\n";
+    json << "    \"layers\": " << settings.layers << ",\n";
+    json << "    \"keys_per_curve\": " << settings.keysPerCurve << ",\n";
+    json << "    \"generate_ms\": " << generateMs << "\n";
+    json << "  },\n";
+    json << "  \"export\": {\n";
+    json << "    \"ascii\": " << (options.asciiOutput ? "true" : "false") << ",\n";
+    json << "    \"fbx_version\": \"" << MetricsWriter::EscapeJson(options.fbxVersion) << "\",\n";
+    json << "    \"embed_media\": " << (options.embedMedia ? "true" : "false") << ",\n";
+    json << "    \"compression\": " << options.compressionLevel << "\n";
+    json << "  },\n";
+    json << "  \"iterations\": " << iterations << ",\n";
+    json << "  \"stages\": {\n";
+    const std::vector<StageTimes>& stages = benchmark.Stages();
+    for (size_t i = 0; i < stages.size(); i++) {
+        json << "    \"" << stages[i].name << "\": { \"min_ms\": " << stages[i].Min()
+             << ", \"mean_ms\": " << stages[i].Mean() << " }" << (i + 1 < stages.size() ? "," : "") << "\n";
+    }
+    json << "  },\n";
+    if (const ReductionSummary* reduction = benchmark.Reduction()) {
+        json << "  \"reduction\": {\n";
+        json << "    \"translation_tolerance\": " << options.translationTolerance << ",\n";
+        json << "    \"rotation_tolerance_deg\": " << options.rotationTolerance << ",\n";
+        json << "    \"keys_before\": " << reduction->keysBefore << ",\n";
+        json << "    \"keys_after\": " << reduction->keysAfter << ",\n";
+        json << "    \"bytes_before\": " << reduction->bytesBefore << ",\n";
+        json << "    \"bytes_after\": " << reduction->bytesAfter << ",\n";
+        json << std::setprecision(6);
+        json << "    \"max_translation_error\": " << reduction->maxTranslationError << ",\n";
+        json << "    \"max_rotation_error_deg\": " << reduction->maxRotationError << "\n";
+        json << std::setprecision(3);
+        json << "  },\n";
+    }
+    if (!formats.empty()) {
+        json << "  \"formats\": {\n";
+        for (size_t i = 0; i < formats.size(); i++) {
+            json << "    \"" << formats[i].name << "\": { \"bytes\": " << formats[i].bytes
+                 << ", \"min_ms\": " << formats[i].exportTimes.Min() << ", \"mean_ms\": " << formats[i].exportTimes.Mean()
+                 << " }" << (i + 1 < formats.size() ? "," : "") << "\n";
+        }
+        json << "  },\n";
+    }
+    if (compareSkinLookup) {
+        json << "  \"skin_lookup\": {\n";
+        json << "    \"skeletons\": " << skinLookup.skeletons << ",\n";
+        json << "    \"mesh_links\": " << skinLookup.meshLinks << ",\n";
+        json << "    \"matches\": " << (skinLookup.matches ? "true" : "false") << ",\n";
+        json << "    \"index\": { \"min_ms\": " << skinLookup.index.Min() << ", \"mean_ms\": " << skinLookup.index.Mean() << " },\n";
+        json << "    \"rescan\": { \"min_ms\": " << skinLookup.rescan.Min() << ", \"mean_ms\": " << skinLookup.rescan.Mean() << " }\n";
+        json << "  },\n";
+    }
+    if (compareMeshTransfer) {
+        json << "  \"mesh_transfer\": {\n";
+        json << "    \"meshes\": " << meshTransfer.meshes << ",\n";
+        json << "    \"control_points\": " << meshTransfer.controlPoints << ",\n";
+        json << "    \"polygons\": " << meshTransfer.polygons << ",\n";
+        json << "    \"influences\": " << meshTransfer.influences << ",\n";
+        json << "    \"bulk\": { \"min_ms\": " << meshTransfer.bulk.Min() << ", \"mean_ms\": " << meshTransfer.bulk.Mean() << " },\n";
+        json << "    \"per_element\": { \"min_ms\": " << meshTransfer.perElement.Min() << ", \"mean_ms\": " << meshTransfer.perElement.Mean() << " }\n";
+        json << "  },\n";
+    }
+    if (options.clipCache) {
+        const std::vector<std::string>& clipCachePaths = benchmark.ClipCachePaths();
+        uintmax_t clipCacheBytes = 0;
+        for (const std::string& path : clipCachePaths) {
+            std::error_code sizeError;
+            clipCacheBytes += fs::file_size(path, sizeError);
+        }
+        json << "  \"clip_cache\": {\n";
+        json << "    \"files\": " << clipCachePaths.size() << ",\n";
+        json << "    \"bytes\": " << clipCacheBytes << ",\n";
+        json << "    \"open_ms_per_file\": " << clipCacheOpenMs << "\n";
+        json << "  },\n";
+    }
+    json << "  \"kernels\": {\n";
+    json << "    \"add_scalar_keys_per_ms\": " << BenchmarkAddScalarKernel() << "\n";
+    json << "  }\n";
+    json << "}\n";
+
+    std::ofstream output(outputPath);
+    output << json.str();
+    if (!output) {
+        std::cerr << "Failed to write results: " << outputPath << std::endl;
+        return 1;
+    }
+
+    std::cout << json.str();
+    return 0;
+}
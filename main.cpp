@@ -1,464 +1,200 @@
-#include <fbxsdk.h>
+#include "FBXProcessor.h"
 #include <iostream>
 #include <string>
 #include <vector>
-#include <filesystem>
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <fstream>
+#include <atomic>
+#include <csignal>
+
+std::atomic<bool> stopWatching{false};
+
+void RequestStop(int) {
+    stopWatching = true;
+}
+
+void PrintUsage(const char* programName) {
+    std::cout << "Usage: " << programName << " <directory_path> [rotate_to_face_z] [--jobs N] [--pipeline] [--max-live-scenes N] [--force] [--dry-run] [--low-memory] [--reduce-keys] [--translation-tolerance U] [--rotation-tolerance DEG] [--ascii] [--fbx-version V] [--embed-media] [--compression N] [--clip-cache] [--metrics file] [--quiet]" << std::endl;
+    std::cout << "  directory_path: Path to directory containing FBX files" << std::endl;
+    std::cout << "  rotate_to_face_z: Optional flag (0 or 1) to rotate actors to face Z direction" << std::endl;
+    std::cout << "  --jobs N: Process N files in parallel (defaults to 1)" << std::endl;
+    std::cout << "  --pipeline: Overlap export of one actor with extraction of the next" << std::endl;
+    std::cout << "  --max-live-scenes N: Extracted scenes kept alive at once in pipelined mode (defaults to 2)" << std::endl;
+    std::cout << "  --force: Rebuild every input, even those the manifest records as up to date" << std::endl;
+    std::cout << "  --dry-run: Report which inputs would be rebuilt without processing them" << std::endl;
+    std::cout << "  --low-memory: Skip unused import data and free each actor's source data once extracted" << std::endl;
+    std::cout << "  --reduce-keys: Drop keys that linear interpolation reproduces within tolerance before export" << std::endl;
+    std::cout << "  --translation-tolerance U: Maximum translation error in scene units (defaults to 0.01)" << std::endl;
+    std::cout << "  --rotation-tolerance DEG: Maximum rotation error in degrees (defaults to 0.1)" << std::endl;
+    std::cout << "  --ascii: Write FBX ascii instead of binary" << std::endl;
+    std::cout << "  --fbx-version V: FBX file version to write, e.g. 2018 or FBX201800 (defaults to the SDK's version)" << std::endl;
+    std::cout << "  --embed-media: Embed referenced media in binary outputs" << std::endl;
+    std::cout << "  --compression N: Array compression level for binary outputs, 0 (off) to 9" << std::endl;
+    std::cout << "  --clip-cache: Also write each actor as a memory-mappable .fbxclip animation cache" << std::endl;
+    std::cout << "  --metrics file: Write per-stage timings and counters per file and actor (.csv for CSV, otherwise JSON)" << std::endl;
+    std::cout << "  --quiet: Only print errors and the final summary" << std::endl;
+    std::cout << "       " << programName << " --watch <directory_path> [rotate_to_face_z] [--status-file file] [--queue-size N] [--settle-seconds S] [processing options]" << std::endl;
+    std::cout << "  --watch: Keep running and process FBX files as they land in the directory, until interrupted" << std::endl;
+    std::cout << "  --status-file file: Where --watch writes throughput and queue depth (defaults to <directory_path>/.fbxprocessor-status.json)" << std::endl;
+    std::cout << "  --queue-size N: Files --watch queues for the workers; more are retried once they settle again (defaults to 16)" << std::endl;
+    std::cout << "  --settle-seconds S: How long a file must stop growing before --watch processes it (defaults to 2)" << std::endl;
+    std::cout << "       " << programName << " analyze <directory_path> [--jobs N] [--report-dir dir] [--quiet]" << std::endl;
+    std::cout << "  analyze: Write a JSON report per FBX file and a rollup.json without extracting anything" << std::endl;
+    std::cout << "  --report-dir dir: Where analyze writes its reports (defaults to <directory_path>/analysis)" << std::endl;
+}
+
+bool WriteMetrics(const std::string& metricsPath, const std::vector<FileResult>& results) {
+    std::vector<FileMetrics> files;
+    for (const FileResult& result : results) {
+        files.push_back(result.metrics);
+    }
+    
+    std::ofstream output(metricsPath);
+    if (fs::path(metricsPath).extension() == ".csv") {
+        MetricsWriter::WriteCsv(output, files);
+    } else {
+        MetricsWriter::WriteJson(output, files);
+    }
+    return static_cast<bool>(output);
+}
 
-namespace fs = std::filesystem;
-
-class FBXProcessor {
-private:
-    FbxManager* fbxManager;
-    
-    FbxScene* CreateNewScene() {
-        FbxScene* scene = FbxScene::Create(fbxManager, "");
-        return scene;
-    }
-
-    std::string GetActorNameFromNode(FbxNode* node) {
-        std::string nodeName = node->GetName();
-        for (size_t i = 0; i < nodeName.length(); i++) {
-            if (!std::isalnum(nodeName[i])) {
-                nodeName[i] = '_';
-            }
-        }
-        return nodeName;
-    }
-    
-    void FindSkeletons(FbxNode* node, std::vector<FbxNode*>& skeletons) {
-        if (node->GetNodeAttribute()) {
-            FbxNodeAttribute::EType attributeType = node->GetNodeAttribute()->GetAttributeType();
-            
-            if (attributeType == FbxNodeAttribute::eSkeleton) {
-                bool isRoot = true;
-                FbxNode* parent = node->GetParent();
-                while (parent) {
-                    if (parent->GetNodeAttribute() && 
-                        parent->GetNodeAttribute()->GetAttributeType() == FbxNodeAttribute::eSkeleton) {
-                        isRoot = false;
-                        break;
-                    }
-                    parent = parent->GetParent();
-                }
-                
-                if (isRoot) {
-                    skeletons.push_back(node);
-                }
-            }
-        }
-        
-        for (int i = 0; i < node->GetChildCount(); i++) {
-            FindSkeletons(node->GetChild(i), skeletons);
-        }
-    }
-    
-    FbxScene* ExtractSkeleton(FbxScene* originalScene, FbxNode* skeletonRoot) {
-        FbxScene* newScene = CreateNewScene();
-        
-        newScene->GetGlobalSettings().SetAxisSystem(originalScene->GetGlobalSettings().GetAxisSystem());
-        newScene->GetGlobalSettings().SetSystemUnit(originalScene->GetGlobalSettings().GetSystemUnit());
-        
-        FbxNode* newRoot = CloneNodeHierarchy(skeletonRoot, newScene->GetRootNode(), originalScene, newScene);
-
-        auto AttachSkinnedMeshes = [&](FbxScene* srcScene, FbxScene* dstScene, FbxNode* skelRoot, FbxNode* dstRoot) {
-            int nodeCount = srcScene->GetNodeCount();
-            for (int i = 0; i < nodeCount; ++i) {
-                FbxNode* node = srcScene->GetNode(i);
-                FbxMesh* mesh = node->GetMesh();
-                    if (!mesh) continue;
-
-                bool linked = false;
-                for (int deformerIndex = 0; deformerIndex < mesh->GetDeformerCount(); ++deformerIndex) {
-                    FbxSkin* skin = FbxCast<FbxSkin>(mesh->GetDeformer(deformerIndex, FbxDeformer::eSkin));
-                        if (!skin) continue;
-
-                    for (int clusterIndex = 0; clusterIndex < skin->GetClusterCount(); ++clusterIndex) {
-                        FbxCluster* cluster = skin->GetCluster(clusterIndex);
-                        FbxNode* link = cluster->GetLink();
-                            if (link && link->GetName() == skelRoot->GetName()) {
-                                linked = true;
-                                break;                   
-                            }
-                    }
-                }
-
-                if (linked) {
-                    FbxNode* clonedMeshNode = CloneNodeHierarchy(node, dstRoot, srcScene, dstScene);
-                    std::cout << "  Attached mesh: " << node->GetName() << std::endl;
-                }
-            }
-        };
-
-        AttachSkinnedMeshes(originalScene, newScene, skeletonRoot, newRoot);
-  
-        CopyAnimation(originalScene, newScene, skeletonRoot, newRoot);
-        
-        return newScene;
-    }
-    
-    FbxNode* CloneNodeHierarchy(FbxNode* sourceNode, FbxNode* destParent, FbxScene* sourceScene, FbxScene* destScene) {
-        if (!sourceNode) return nullptr;
-        
-        FbxNode* newNode = FbxNode::Create(destScene, sourceNode->GetName());
-        destParent->AddChild(newNode);
-        
-        if (sourceNode->GetNodeAttribute()) {
-            FbxNodeAttribute* originalAttribute = sourceNode->GetNodeAttribute();
-            FbxNodeAttribute::EType attributeType = originalAttribute->GetAttributeType();
-            
-            if (attributeType == FbxNodeAttribute::eSkeleton) {
-                FbxSkeleton* skeleton = FbxSkeleton::Create(destScene, "");
-                skeleton->SetSkeletonType(((FbxSkeleton*)originalAttribute)->GetSkeletonType());
-                newNode->SetNodeAttribute(skeleton);
-            } else if (attributeType == FbxNodeAttribute::eMesh) {
-                FbxMesh* originalMesh = (FbxMesh*)originalAttribute;
-                FbxMesh* newMesh = FbxMesh::Create(destScene, originalMesh->GetName());
-                
-                newMesh->InitControlPoints(originalMesh->GetControlPointsCount());
-                FbxVector4* controlPoints = newMesh->GetControlPoints();
-                FbxVector4* originalControlPoints = originalMesh->GetControlPoints();
-                
-                for (int i = 0; i < originalMesh->GetControlPointsCount(); i++) {
-                    controlPoints[i] = originalControlPoints[i];
-                }
-                
-                for (int i = 0; i < originalMesh->GetPolygonCount(); i++) {
-                    int polygonSize = originalMesh->GetPolygonSize(i);
-                    newMesh->BeginPolygon();
-                    
-                    for (int j = 0; j < polygonSize; j++) {
-                        int index = originalMesh->GetPolygonVertex(i, j);
-                        newMesh->AddPolygon(index);
-                    }
-                    
-                    newMesh->EndPolygon();
-                }
-                
-                newNode->SetNodeAttribute(newMesh);
-            }
-        }
-        
-        newNode->LclTranslation.Set(sourceNode->LclTranslation.Get());
-        newNode->LclRotation.Set(sourceNode->LclRotation.Get());
-        newNode->LclScaling.Set(sourceNode->LclScaling.Get());
-        
-        for (int i = 0; i < sourceNode->GetChildCount(); i++) {
-            CloneNodeHierarchy(sourceNode->GetChild(i), newNode, sourceScene, destScene);
-        }
-        
-        return newNode;
-    }
-    
-    void CopyAnimation(FbxScene* sourceScene, FbxScene* destScene, FbxNode* sourceNode, FbxNode* destNode) {
-        int animStackCount = sourceScene->GetSrcObjectCount<FbxAnimStack>();
-        
-        for (int stackIndex = 0; stackIndex < animStackCount; stackIndex++) {
-            FbxAnimStack* sourceStack = sourceScene->GetSrcObject<FbxAnimStack>(stackIndex);
-            
-            FbxAnimStack* destStack = FbxAnimStack::Create(destScene, sourceStack->GetName());
-            
-            int layerCount = sourceStack->GetMemberCount<FbxAnimLayer>();
-            
-            for (int layerIndex = 0; layerIndex < layerCount; layerIndex++) {
-                FbxAnimLayer* sourceLayer = sourceStack->GetMember<FbxAnimLayer>(layerIndex);
-                FbxAnimLayer* destLayer = FbxAnimLayer::Create(destScene, sourceLayer->GetName());
-                destStack->AddMember(destLayer);
-                
-                CopyNodeAnimation(sourceNode, destNode, sourceLayer, destLayer);
-            }
-        }
-    }
-    
-    void CopyNodeAnimation(FbxNode* sourceNode, FbxNode* destNode, FbxAnimLayer* sourceLayer, FbxAnimLayer* destLayer) {
-        CopyAnimationCurve(sourceNode->LclTranslation.GetCurve(sourceLayer, FBXSDK_CURVENODE_COMPONENT_X), 
-                           destNode->LclTranslation.GetCurve(destLayer, FBXSDK_CURVENODE_COMPONENT_X, true));
-        CopyAnimationCurve(sourceNode->LclTranslation.GetCurve(sourceLayer, FBXSDK_CURVENODE_COMPONENT_Y), 
-                           destNode->LclTranslation.GetCurve(destLayer, FBXSDK_CURVENODE_COMPONENT_Y, true));
-        CopyAnimationCurve(sourceNode->LclTranslation.GetCurve(sourceLayer, FBXSDK_CURVENODE_COMPONENT_Z), 
-                           destNode->LclTranslation.GetCurve(destLayer, FBXSDK_CURVENODE_COMPONENT_Z, true));
-        
-        CopyAnimationCurve(sourceNode->LclRotation.GetCurve(sourceLayer, FBXSDK_CURVENODE_COMPONENT_X), 
-                           destNode->LclRotation.GetCurve(destLayer, FBXSDK_CURVENODE_COMPONENT_X, true));
-        CopyAnimationCurve(sourceNode->LclRotation.GetCurve(sourceLayer, FBXSDK_CURVENODE_COMPONENT_Y), 
-                           destNode->LclRotation.GetCurve(destLayer, FBXSDK_CURVENODE_COMPONENT_Y, true));
-        CopyAnimationCurve(sourceNode->LclRotation.GetCurve(sourceLayer, FBXSDK_CURVENODE_COMPONENT_Z), 
-                           destNode->LclRotation.GetCurve(destLayer, FBXSDK_CURVENODE_COMPONENT_Z, true));
-        
-        CopyAnimationCurve(sourceNode->LclScaling.GetCurve(sourceLayer, FBXSDK_CURVENODE_COMPONENT_X), 
-                           destNode->LclScaling.GetCurve(destLayer, FBXSDK_CURVENODE_COMPONENT_X, true));
-        CopyAnimationCurve(sourceNode->LclScaling.GetCurve(sourceLayer, FBXSDK_CURVENODE_COMPONENT_Y), 
-                           destNode->LclScaling.GetCurve(destLayer, FBXSDK_CURVENODE_COMPONENT_Y, true));
-        CopyAnimationCurve(sourceNode->LclScaling.GetCurve(sourceLayer, FBXSDK_CURVENODE_COMPONENT_Z), 
-                           destNode->LclScaling.GetCurve(destLayer, FBXSDK_CURVENODE_COMPONENT_Z, true));
-        
-        for (int i = 0; i < sourceNode->GetChildCount() && i < destNode->GetChildCount(); i++) {
-            CopyNodeAnimation(sourceNode->GetChild(i), destNode->GetChild(i), sourceLayer, destLayer);
-        }
-    }
-    
-    void CopyAnimationCurve(FbxAnimCurve* sourceCurve, FbxAnimCurve* destCurve) {
-        if (!sourceCurve || !destCurve) return;
-        
-        int keyCount = sourceCurve->KeyGetCount();
-        
-        for (int keyIndex = 0; keyIndex < keyCount; keyIndex++) {
-            FbxTime keyTime = sourceCurve->KeyGetTime(keyIndex);
-            float keyValue = sourceCurve->KeyGetValue(keyIndex);
-            
-            int destKeyIndex = destCurve->KeyAdd(keyTime);
-            destCurve->KeySetValue(destKeyIndex, keyValue);
-            destCurve->KeySetInterpolation(destKeyIndex, sourceCurve->KeyGetInterpolation(keyIndex));
-        }
-    }
-    
-    void CenterActor(FbxScene* scene, bool rotateToFaceZ = false) {
-        FbxNode* rootNode = scene->GetRootNode();
-        std::vector<FbxNode*> skeletons;
-        FindSkeletons(rootNode, skeletons);
-        
-        if (skeletons.empty()) {
-            std::cerr << "No skeletons found in the scene!" << std::endl;
-            return;
-        }
-        
-        FbxNode* skeletonRoot = skeletons[0];
-        
-        FbxDouble3 initialPosition = skeletonRoot->LclTranslation.Get();
-        
-        FbxDouble3 newPosition = FbxDouble3(0.0, initialPosition[1], 0.0);
-        FbxDouble3 translationOffset = FbxDouble3(
-            -initialPosition[0],
-            0.0,  // keep Y unchanged
-            -initialPosition[2]
-        );
-        
-        ApplyTranslationToNodeAndAnimation(skeletonRoot, translationOffset, scene);
-        
-        // optionally rotate to face positive Z direction
-        if (rotateToFaceZ) {
-            
-            FbxNode* hipNode = skeletonRoot; // the root node or hip node is the reference ?
-            FbxDouble3 rotation = hipNode->LclRotation.Get();
-            
-            // rotation to face positive Z should set absolute rotation to 0 degrees around Y axis ?
-            // FbxDouble3 newRotation = FbxDouble3(rotation[0], 0.0, rotation[2]);
-            // FbxDouble3 rotationOffset = FbxDouble3(0.0, -rotation[1], 0.0);
-            
-
-            // forward vector estimaiton based on a child node (e.g., hips to spine or hips to head) (fix?)
-            FbxDouble3 rotationOffset;
-            FbxNode* spineNode = nullptr;
-            for (int i = 0; i < hipNode->GetChildCount(); ++i) {
-                FbxNode* child = hipNode->GetChild(i);
-                if (child->GetName() && std::string(child->GetName()).find("Spine") != std::string::npos) {
-                    spineNode = child;
-                    break;
-                }
-            }
-            if (!spineNode && hipNode->GetChildCount() > 0) {
-                spineNode = hipNode->GetChild(0); // fallback
+int main(int argc, char* argv[]) {
+    std::vector<std::string> positional;
+    ProcessingOptions options;
+    std::string metricsPath;
+    std::string reportDirectory;
+    std::string watchDirectory;
+    WatchOptions watchOptions;
+    
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--jobs") {
+            char* end = nullptr;
+            long jobs = i + 1 < argc ? std::strtol(argv[i + 1], &end, 10) : 0;
+            if (i + 1 >= argc || end == argv[i + 1] || *end != '\0' || jobs <= 0 || jobs > 1024) {
+                std::cerr << "Error: --jobs needs a number of workers between 1 and 1024" << std::endl;
+                PrintUsage(argv[0]);
+                return 1;
             }
-
-            if (spineNode) {
-                FbxVector4 hipPos = hipNode->EvaluateGlobalTransform().GetT();
-                FbxVector4 spinePos = spineNode->EvaluateGlobalTransform().GetT();
-
-                FbxVector4 forward = spinePos - hipPos;
-                double angle = atan2(forward[0], forward[2]) * 180.0 / 3.141592653589793;
-
-                rotationOffset = FbxDouble3(0.0, -angle, 0.0);
-                ApplyRotationToNodeAndAnimation(hipNode, rotationOffset, scene);
+            options.jobs = static_cast<int>(jobs);
+            i++;
+        } else if (arg == "--pipeline") {
+            options.pipeline = true;
+        } else if (arg == "--max-live-scenes" && i + 1 < argc) {
+            options.maxLiveScenes = std::max(1, std::atoi(argv[++i]));
+        } else if (arg == "--force") {
+            options.force = true;
+        } else if (arg == "--dry-run") {
+            options.dryRun = true;
+        } else if (arg == "--low-memory") {
+            options.lowMemory = true;
+        } else if (arg == "--reduce-keys") {
+            options.reduceKeys = true;
+        } else if (arg == "--translation-tolerance" && i + 1 < argc) {
+            options.translationTolerance = std::max(0.0, std::atof(argv[++i]));
+        } else if (arg == "--rotation-tolerance" && i + 1 < argc) {
+            options.rotationTolerance = std::max(0.0, std::atof(argv[++i]));
+        } else if (arg == "--ascii") {
+            options.asciiOutput = true;
+        } else if (arg == "--fbx-version" && i + 1 < argc) {
+            options.fbxVersion = argv[++i];
+            // a bare year is shorthand for the SDK's version string
+            if (options.fbxVersion.size() == 4 &&
+                std::all_of(options.fbxVersion.begin(), options.fbxVersion.end(), [](unsigned char c) { return std::isdigit(c) != 0; })) {
+                options.fbxVersion = "FBX" + options.fbxVersion + "00";
             }
-
-            ApplyRotationToNodeAndAnimation(hipNode, rotationOffset, scene);
-        }
-    }
-    
-    void ApplyTranslationToNodeAndAnimation(FbxNode* node, const FbxDouble3& translationOffset, FbxScene* scene) {
-        FbxDouble3 currentTranslation = node->LclTranslation.Get();
-        
-        FbxDouble3 newTranslation = FbxDouble3(
-            currentTranslation[0] + translationOffset[0],
-            currentTranslation[1] + translationOffset[1],
-            currentTranslation[2] + translationOffset[2]
-        );
+        } else if (arg == "--embed-media") {
+            options.embedMedia = true;
+        } else if (arg == "--compression" && i + 1 < argc) {
+            options.compressionLevel = std::clamp(std::atoi(argv[++i]), 0, 9);
+        } else if (arg == "--clip-cache") {
+            options.clipCache = true;
+        } else if (arg == "--metrics" && i + 1 < argc) {
+            metricsPath = argv[++i];
+        } else if (arg == "--report-dir" && i + 1 < argc) {
+            reportDirectory = argv[++i];
+        } else if (arg == "--watch" && i + 1 < argc) {
+            watchDirectory = argv[++i];
+        } else if (arg == "--status-file" && i + 1 < argc) {
+            watchOptions.statusPath = argv[++i];
+        } else if (arg == "--queue-size" && i + 1 < argc) {
+            watchOptions.queueCapacity = static_cast<size_t>(std::max(1, std::atoi(argv[++i])));
+        } else if (arg == "--settle-seconds" && i + 1 < argc) {
+            watchOptions.settleTime = std::chrono::milliseconds(static_cast<int64_t>(std::max(0.0, std::atof(argv[++i])) * 1000.0));
+        } else if (arg == "--quiet") {
+            quietLogging = true;
+        } else {
+            positional.push_back(arg);
+        }
+    }
+    
+    // the tool owns its process, so the peak RSS can be reported per file
+    options.resetPeakRss = true;
+    
+    if (!watchDirectory.empty()) {
+        // the directory comes with --watch, so the only positional argument is the rotate flag
+        options.rotateToFaceZ = !positional.empty() && positional[0] == "1";
+        
+        std::signal(SIGINT, RequestStop);
+        std::signal(SIGTERM, RequestStop);
         
-        // setting the new static translation does not work ?
-        // node->LclTranslation.Set(newTranslation);
-
-        int animStackCount = scene->GetSrcObjectCount<FbxAnimStack>();
-        
-        for (int stackIndex = 0; stackIndex < animStackCount; stackIndex++) {
-            FbxAnimStack* animStack = scene->GetSrcObject<FbxAnimStack>(stackIndex);
-            scene->SetCurrentAnimationStack(animStack);
-            
-            int layerCount = animStack->GetMemberCount<FbxAnimLayer>();
-            
-            for (int layerIndex = 0; layerIndex < layerCount; layerIndex++) {
-                FbxAnimLayer* animLayer = animStack->GetMember<FbxAnimLayer>(layerIndex);
-
-                FbxAnimCurve* xCurve = node->LclTranslation.GetCurve(animLayer, FBXSDK_CURVENODE_COMPONENT_X);
-                if (xCurve) {
-                    for (int keyIndex = 0; keyIndex < xCurve->KeyGetCount(); keyIndex++) {
-                        float keyValue = xCurve->KeyGetValue(keyIndex);
-                        xCurve->KeySetValue(keyIndex, keyValue + translationOffset[0]);
-                    }
-                }
-
-                FbxAnimCurve* zCurve = node->LclTranslation.GetCurve(animLayer, FBXSDK_CURVENODE_COMPONENT_Z);
-                if (zCurve) {
-                    for (int keyIndex = 0; keyIndex < zCurve->KeyGetCount(); keyIndex++) {
-                        float keyValue = zCurve->KeyGetValue(keyIndex);
-                        zCurve->KeySetValue(keyIndex, keyValue + translationOffset[2]);
-                    }
-                }
-            }
+        try {
+            FBXProcessor processor;
+            return processor.WatchDirectory(watchDirectory, options, watchOptions, stopWatching) ? 0 : 1;
+        } catch (const std::exception& e) {
+            std::cerr << "Error: " << e.what() << std::endl;
+            return 1;
         }
     }
     
-    void ApplyRotationToNodeAndAnimation(FbxNode* node, const FbxDouble3& rotationOffset, FbxScene* scene) {
-        FbxDouble3 currentRotation = node->LclRotation.Get();
-        
-        FbxDouble3 newRotation = FbxDouble3(
-            currentRotation[0] + rotationOffset[0],
-            currentRotation[1] + rotationOffset[1],
-            currentRotation[2] + rotationOffset[2]
-        );
-        
-        node->LclRotation.Set(newRotation);
-        
-        int animStackCount = scene->GetSrcObjectCount<FbxAnimStack>();
-        
-        for (int stackIndex = 0; stackIndex < animStackCount; stackIndex++) {
-            FbxAnimStack* animStack = scene->GetSrcObject<FbxAnimStack>(stackIndex);
-            scene->SetCurrentAnimationStack(animStack);
-            
-            int layerCount = animStack->GetMemberCount<FbxAnimLayer>();
-            
-            for (int layerIndex = 0; layerIndex < layerCount; layerIndex++) {
-                FbxAnimLayer* animLayer = animStack->GetMember<FbxAnimLayer>(layerIndex);
-                
-                FbxAnimCurve* yCurve = node->LclRotation.GetCurve(animLayer, FBXSDK_CURVENODE_COMPONENT_Y);
-                if (yCurve) {
-                    for (int keyIndex = 0; keyIndex < yCurve->KeyGetCount(); keyIndex++) {
-                        float keyValue = yCurve->KeyGetValue(keyIndex);
-                        yCurve->KeySetValue(keyIndex, keyValue + rotationOffset[1]);
-                    }
-                }
-            }
-        }
-    }
-
-public:
-    FBXProcessor() {
-        fbxManager = FbxManager::Create();
-        
-        FbxIOSettings* ios = FbxIOSettings::Create(fbxManager, IOSROOT);
-        fbxManager->SetIOSettings(ios);
+    bool analyze = !positional.empty() && positional[0] == "analyze";
+    if (analyze) {
+        positional.erase(positional.begin());
     }
     
-    ~FBXProcessor() {
-        fbxManager->Destroy();
+    if (positional.empty()) {
+        PrintUsage(argv[0]);
+        return 1;
     }
     
-    void ProcessFile(const std::string& inputFilePath, bool rotateToFaceZ = false) {
-        std::cout << "Processing: " << inputFilePath << std::endl;
-        
-        FbxImporter* importer = FbxImporter::Create(fbxManager, "");
-        
-        if (!importer->Initialize(inputFilePath.c_str(), -1, fbxManager->GetIOSettings())) {
-            std::cerr << "Failed to initialize importer: " << importer->GetStatus().GetErrorString() << std::endl;
-            importer->Destroy();
-            return;
-        }
-        
-        FbxScene* scene = FbxScene::Create(fbxManager, "importScene");
-        
-        if (!importer->Import(scene)) {
-            std::cerr << "Failed to import scene: " << importer->GetStatus().GetErrorString() << std::endl;
-            importer->Destroy();
-            scene->Destroy();
-            return;
+    if (analyze) {
+        if (reportDirectory.empty()) {
+            reportDirectory = (fs::path(positional[0]) / "analysis").string();
         }
         
-        importer->Destroy();
-        
-        std::vector<FbxNode*> skeletons;
-        FindSkeletons(scene->GetRootNode(), skeletons);
-        
-        std::cout << "Found " << skeletons.size() << " skeletons in the file." << std::endl;
-        
-        fs::path inputPath(inputFilePath);
-        std::string baseFileName = inputPath.stem().string();
-        std::string outputDir = inputPath.parent_path().string();
-        
-        for (FbxNode* skeleton : skeletons) {
-            std::string actorName = GetActorNameFromNode(skeleton);
-            std::cout << "  Processing skeleton: " << actorName << std::endl;
-            
-            FbxScene* newScene = ExtractSkeleton(scene, skeleton);
-            
-            CenterActor(newScene, rotateToFaceZ);
-            
-            std::string outputFileName = baseFileName + "_" + actorName + ".fbx";
-            std::string outputFilePath = (fs::path(outputDir) / outputFileName).string();
-            
-            FbxExporter* exporter = FbxExporter::Create(fbxManager, "");
-            
-            if (!exporter->Initialize(outputFilePath.c_str(), -1, fbxManager->GetIOSettings())) {
-                std::cerr << "Failed to initialize exporter: " << exporter->GetStatus().GetErrorString() << std::endl;
-                exporter->Destroy();
-                newScene->Destroy();
-                continue;
-            }
-            
-            if (!exporter->Export(newScene)) {
-                std::cerr << "Failed to export scene: " << exporter->GetStatus().GetErrorString() << std::endl;
-            } else {
-                std::cout << "  Successfully exported: " << outputFilePath << std::endl;
-            }
-            
-            exporter->Destroy();
-            newScene->Destroy();
-        }
-        
-        scene->Destroy();
-    }
-    
-    void ProcessDirectory(const std::string& directoryPath, bool rotateToFaceZ = false) {
+        std::vector<SceneReport> reports;
         try {
-            std::cout << "Processing directory: " << directoryPath << std::endl;
-            
-            for (const auto& entry : fs::directory_iterator(directoryPath)) {
-                if (entry.is_regular_file() && entry.path().extension() == ".fbx") {
-                    ProcessFile(entry.path().string(), rotateToFaceZ);
-                }
-            }
+            FBXProcessor processor;
+            reports = processor.AnalyzeDirectory(positional[0], reportDirectory, options);
         } catch (const std::exception& e) {
-            std::cerr << "Error processing directory: " << e.what() << std::endl;
+            std::cerr << "Error: " << e.what() << std::endl;
+            return 1;
         }
-    }
-};
-
-int main(int argc, char* argv[]) {
-    if (argc < 2) {
-        std::cout << "Usage: " << argv[0] << " <directory_path> [rotate_to_face_z]" << std::endl;
-        std::cout << "  directory_path: Path to directory containing FBX files" << std::endl;
-        std::cout << "  rotate_to_face_z: Optional flag (0 or 1) to rotate actors to face Z direction" << std::endl;
-        return 1;
+        
+        bool anyFailed = std::any_of(reports.begin(), reports.end(), [](const SceneReport& r) { return !r.success; });
+        return anyFailed ? 1 : 0;
     }
     
-    std::string directoryPath = argv[1];
-    bool rotateToFaceZ = (argc > 2) ? (std::string(argv[2]) == "1") : false;
+    std::string directoryPath = positional[0];
+    options.rotateToFaceZ = (positional.size() > 1) ? (positional[1] == "1") : false;
     
+    std::vector<FileResult> results;
     try {
         FBXProcessor processor;
-        processor.ProcessDirectory(directoryPath, rotateToFaceZ);
+        results = processor.ProcessDirectory(directoryPath, options);
     } catch (const std::exception& e) {
         std::cerr << "Error: " << e.what() << std::endl;
         return 1;
     }
     
+    if (!metricsPath.empty() && !WriteMetrics(metricsPath, results)) {
+        std::cerr << "Failed to write metrics: " << metricsPath << std::endl;
+    }
+    
     std::cout << "Processing complete!" << std::endl;
-    return 0;
+    
+    bool anyFailed = std::any_of(results.begin(), results.end(), [](const FileResult& r) { return !r.success; });
+    return anyFailed ? 1 : 0;
 }
\ No newline at end of file
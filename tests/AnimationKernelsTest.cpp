@@ -0,0 +1,149 @@
+#include "AnimationBuffer.h"
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+// Checks the per-key kernels in AnimationBuffer.h against plain double-precision loops. Needs no
+// FBX SDK. Counts are not multiples of the vector width so the scalar tails are covered too.
+
+static int failures = 0;
+
+#define CHECK(condition)                                                          \
+    do {                                                                          \
+        if (!(condition)) {                                                       \
+            std::fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #condition); \
+            failures++;                                                           \
+        }                                                                         \
+    } while (0)
+
+static bool Near(double a, double b, double tolerance) {
+    return std::fabs(a - b) <= tolerance;
+}
+
+static void TestAddScalar() {
+    for (size_t count : { 0, 1, 3, 4, 37, 1024 }) {
+        AnimationChannel channel;
+        channel.Resize(count);
+        for (size_t i = 0; i < count; i++) {
+            channel.values[i] = static_cast<float>(i) * 0.5f - 10.0f;
+        }
+
+        AnimationKernels::AddScalar(channel, 2.25f);
+
+        for (size_t i = 0; i < count; i++) {
+            CHECK(channel.values[i] == static_cast<float>(i) * 0.5f - 10.0f + 2.25f);
+        }
+    }
+}
+
+static void TestRotateXZ() {
+    const double pi = 3.141592653589793;
+    for (double yawDegrees : { 0.0, 90.0, -37.5, 180.0 }) {
+        for (size_t count : { 1, 5, 37 }) {
+            double radians = yawDegrees * pi / 180.0;
+            double cosYaw = std::cos(radians), sinYaw = std::sin(radians);
+            double centerX = 3.5, centerZ = -12.0;
+
+            AnimationChannel channelX, channelZ;
+            channelX.Resize(count);
+            channelZ.Resize(count);
+            for (size_t i = 0; i < count; i++) {
+                channelX.values[i] = static_cast<float>(100.0 * std::sin(i * 0.3));
+                channelZ.values[i] = static_cast<float>(-50.0 + 7.0 * i);
+            }
+            std::vector<float> originalX = channelX.values, originalZ = channelZ.values;
+
+            AnimationKernels::RotateXZ(channelX, channelZ, static_cast<float>(cosYaw), static_cast<float>(sinYaw),
+                                       static_cast<float>(centerX), static_cast<float>(centerZ));
+
+            for (size_t i = 0; i < count; i++) {
+                double px = originalX[i] + centerX, pz = originalZ[i] + centerZ;
+                double expectedX = cosYaw * px + sinYaw * pz - centerX;
+                double expectedZ = -sinYaw * px + cosYaw * pz - centerZ;
+                CHECK(Near(channelX.values[i], expectedX, 1e-3));
+                CHECK(Near(channelZ.values[i], expectedZ, 1e-3));
+                // a rotation about the center keeps the distance to it
+                double radius = std::hypot(px, pz);
+                CHECK(Near(std::hypot(channelX.values[i] + centerX, channelZ.values[i] + centerZ), radius, 1e-3));
+            }
+        }
+    }
+
+    // a yaw of +90 degrees takes +Z to +X
+    float x = 0.0f, z = 1.0f;
+    AnimationKernels::RotateXZ(&x, &z, 1, 0.0f, 1.0f, 0.0f, 0.0f);
+    CHECK(Near(x, 1.0, 1e-6) && Near(z, 0.0, 1e-6));
+}
+
+// Synthetic curves at 120 fps: smooth motion, a held pose with steps, a ramp and jittery data.
+static std::vector<float> SyntheticCurve(int kind, size_t count) {
+    std::vector<float> values(count);
+    unsigned state = 12345u;
+    for (size_t i = 0; i < count; i++) {
+        double t = static_cast<double>(i) / 120.0;
+        switch (kind) {
+        case 0: values[i] = static_cast<float>(40.0 * std::sin(t * 2.0) + 5.0 * std::sin(t * 11.0)); break;
+        case 1: values[i] = static_cast<float>((i / 50) % 2 ? 90.0 : -15.0); break;
+        case 2: values[i] = static_cast<float>(3.0 * t - 7.0); break;
+        default:
+            state = state * 1103515245u + 12345u;
+            values[i] = static_cast<float>(10.0 * t + ((state >> 16) % 1000) / 1000.0 - 0.5);
+            break;
+        }
+    }
+    return values;
+}
+
+static void TestReduceLinear() {
+    const int64_t ticksPerFrame = 46186158000LL / 120;
+    for (int kind = 0; kind < 4; kind++) {
+        for (size_t count : { 1, 2, 3, 240, 2000 }) {
+            std::vector<float> values = SyntheticCurve(kind, count);
+            std::vector<int64_t> times(count);
+            for (size_t i = 0; i < count; i++) {
+                times[i] = static_cast<int64_t>(i) * ticksPerFrame;
+            }
+
+            for (float tolerance : { 0.0001f, 0.01f, 0.5f, 5.0f }) {
+                std::vector<uint32_t> kept = AnimationKernels::ReduceLinear(times.data(), values.data(), count, tolerance);
+
+                CHECK(!kept.empty());
+                CHECK(kept.front() == 0);
+                CHECK(kept.back() == count - 1);
+                CHECK(kept.size() <= count);
+                for (size_t k = 1; k < kept.size(); k++) {
+                    CHECK(kept[k] > kept[k - 1]);
+                }
+                // float values, double interpolation: allow rounding on top of the tolerance
+                CHECK(AnimationKernels::MaxLinearError(times.data(), values.data(), count, kept) <= tolerance + 1e-4);
+            }
+        }
+    }
+
+    // a ramp needs only its end points
+    std::vector<float> ramp = SyntheticCurve(2, 500);
+    std::vector<int64_t> rampTimes(ramp.size());
+    for (size_t i = 0; i < ramp.size(); i++) {
+        rampTimes[i] = static_cast<int64_t>(i) * ticksPerFrame;
+    }
+    CHECK(AnimationKernels::ReduceLinear(rampTimes.data(), ramp.data(), ramp.size(), 0.01f).size() == 2);
+
+    // dropping the middle key of a spike is measured as the spike's height
+    int64_t spikeTimes[] = { 0, 1, 2 };
+    float spike[] = { 0.0f, 3.0f, 0.0f };
+    CHECK(Near(AnimationKernels::MaxLinearError(spikeTimes, spike, 3, { 0, 2 }), 3.0, 1e-9));
+    CHECK(AnimationKernels::ReduceLinear(spikeTimes, spike, 3, 1.0f).size() == 3);
+}
+
+int main() {
+    TestAddScalar();
+    TestRotateXZ();
+    TestReduceLinear();
+
+    if (failures) {
+        std::fprintf(stderr, "%d check(s) failed\n", failures);
+        return 1;
+    }
+    std::printf("All animation kernel checks passed\n");
+    return 0;
+}
@@ -0,0 +1,107 @@
+#include "Manifest.h"
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+// Checks which files of a directory count as inputs across runs, with and without a manifest.
+// Runs are simulated the way ProcessDirectory records them: every input gets a manifest entry
+// listing the [stem]_[actor].fbx files it wrote. Needs no FBX SDK.
+
+namespace fs = std::filesystem;
+
+static int failures = 0;
+
+#define CHECK(condition)                                                          \
+    do {                                                                          \
+        if (!(condition)) {                                                       \
+            std::fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #condition); \
+            failures++;                                                           \
+        }                                                                         \
+    } while (0)
+
+static void Touch(const fs::path& path) {
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file << path.filename().string();
+}
+
+// The .fbx files a run over directory would pick up as inputs, sorted by name.
+static std::vector<std::string> Inputs(const fs::path& directory, const Manifest& manifest) {
+    std::unordered_set<std::string> outputs = manifest.OutputsIn(directory);
+    std::vector<std::string> inputs;
+    for (const auto& entry : fs::directory_iterator(directory)) {
+        std::string name = entry.path().filename().string();
+        if (entry.path().extension() == ".fbx" && !outputs.count(name)) inputs.push_back(name);
+    }
+    std::sort(inputs.begin(), inputs.end());
+    return inputs;
+}
+
+// Records a run that wrote one output per actor for every input, then saves the manifest.
+static void RecordRun(const fs::path& directory, Manifest& manifest, const std::vector<std::string>& inputs,
+                      const std::vector<std::string>& actors) {
+    for (const std::string& input : inputs) {
+        ManifestEntry entry;
+        entry.size = fs::file_size(directory / input);
+        entry.modifiedTime = Manifest::ModifiedTime(directory / input);
+        entry.contentHash = ComputeContentHash(directory / input);
+        for (const std::string& actor : actors) {
+            std::string output = fs::path(input).stem().string() + "_" + actor + ".fbx";
+            Touch(directory / output);
+            entry.outputs.push_back(output);
+        }
+        manifest.Set(input, std::move(entry));
+    }
+    CHECK(manifest.Save(directory / Manifest::FileName));
+}
+
+static void TestOutputsWithoutManifest() {
+    fs::path directory = fs::temp_directory_path() / "fbxprocessor_manifest_test";
+    fs::remove_all(directory);
+    fs::create_directories(directory);
+
+    // a directory processed before it had a manifest, plus a take with an underscore of its own
+    Touch(directory / "walk.fbx");
+    Touch(directory / "walk_Hips.fbx");
+    Touch(directory / "walk_Actor_02.fbx");
+    Touch(directory / "run_fast.fbx");
+    Touch(directory / "notes.txt");
+
+    const std::vector<std::string> expected = { "run_fast.fbx", "walk.fbx" };
+
+    // first run: no manifest, so earlier outputs are recognised by name only
+    Manifest first;
+    CHECK(!first.Load(directory / Manifest::FileName));
+    std::vector<std::string> inputs = Inputs(directory, first);
+    CHECK(inputs == expected);
+    RecordRun(directory, first, inputs, { "Hips", "Actor_02" });
+
+    // second run: the manifest lists the outputs, and nothing new is picked up
+    Manifest second;
+    CHECK(second.Load(directory / Manifest::FileName));
+    CHECK(Inputs(directory, second) == expected);
+    CHECK(second.OutputsIn(directory).count("run_fast_Hips.fbx") == 1);
+
+    // a file recorded as an input stays one even though its name looks like an output
+    ManifestEntry input;
+    second.Set("walk_Hips.fbx", input);
+    CHECK(second.OutputsIn(directory).count("walk_Hips.fbx") == 1);
+    Manifest third;
+    third.Set("walk_Actor_02.fbx", input);
+    CHECK(third.OutputsIn(directory).count("walk_Actor_02.fbx") == 0);
+
+    fs::remove_all(directory);
+}
+
+int main() {
+    TestOutputsWithoutManifest();
+
+    if (failures) {
+        std::fprintf(stderr, "%d check(s) failed\n", failures);
+        return 1;
+    }
+    std::printf("All manifest checks passed\n");
+    return 0;
+}